@@ -0,0 +1,173 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "cvx.h"
+#include "median.h"
+
+
+/******************************************************************************
+ ******* macro ****************************************************************
+ ******************************************************************************/
+#define REPS	(3)
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* variables ************************************************************
+ ******************************************************************************/
+static const int	mpx[]	= {1, 2, 4, 8, 12};
+static const int	ksizes[]	= {3, 5};
+static const struct {
+	int		method;
+	const char	*name;
+} methods[]	= {
+	{MEDIAN_ALX,	"alx"},
+	{MEDIAN_NET,	"net"},
+};
+
+
+/******************************************************************************
+ ******* static functions (prototypes) ****************************************
+ ******************************************************************************/
+static
+void	fill	(uint8_t *buf, ptrdiff_t w, ptrdiff_t h);
+static
+double	now	(void);
+
+
+/******************************************************************************
+ ******* main *****************************************************************
+ ******************************************************************************/
+/*
+ * Time median_blur() on 4:3 gray images from 1 to 12 Mpx, with the kernels
+ * of the reader (3x3 and 5x5).  The best of REPS runs is reported, and the
+ * output of every method is checked to be the same as that of libalx.
+ */
+int	main	(void)
+{
+	img_s		*img, *ref;
+	uint8_t		*src, *buf, *rbuf;
+	ptrdiff_t	w, h;
+	double		t, best;
+	bool		exact, all;
+	int		status;
+
+	status	= EXIT_FAILURE;
+	all	= true;
+	if (alx_cv_init_img(&img))
+		return	status;
+	if (alx_cv_init_img(&ref))
+		goto err0;
+
+	printf("Mpx\tw\th\tksize\tmethod\tms\tns/px\texact\n");
+	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(mpx); i++) {
+		h	= sqrt(mpx[i] * 1e6 * 3 / 4);
+		w	= h * 4 / 3;
+		src	= malloc(w * h);
+		buf	= malloc(w * h);
+		rbuf	= malloc(w * h);
+		if (!src || !buf || !rbuf
+				|| cvx_wrap_gray(img, buf, w, h, w)
+				|| cvx_wrap_gray(ref, rbuf, w, h, w)) {
+			free(rbuf);
+			free(buf);
+			free(src);
+			goto err;
+		}
+		fill(src, w, h);
+
+		for (ptrdiff_t k = 0; k < ARRAY_SSIZE(ksizes); k++) {
+			memcpy(rbuf, src, w * h);
+			median_blur(ref, MEDIAN_ALX, ksizes[k]);
+			for (ptrdiff_t j = 0; j < ARRAY_SSIZE(methods); j++) {
+				best	= INFINITY;
+				for (int r = 0; r < REPS; r++) {
+					memcpy(buf, src, w * h);
+					t	= now();
+					median_blur(img, methods[j].method,
+								ksizes[k]);
+					t	= now() - t;
+					if (t < best)
+						best	= t;
+				}
+				exact	= !memcmp(buf, rbuf, w * h);
+				printf("%i\t%ti\t%ti\t%i\t%s\t%.1f\t%.2f\t%s\n",
+						mpx[i], w, h, ksizes[k],
+						methods[j].name, best * 1e3,
+						best * 1e9 / (w * h),
+						exact ? "yes" : "NO");
+				all	&= exact;
+			}
+		}
+		free(rbuf);
+		free(buf);
+		free(src);
+	}
+
+	if (all)
+		status	= EXIT_SUCCESS;
+err:	alx_cv_deinit_img(ref);
+err0:	alx_cv_deinit_img(img);
+	return	status;
+}
+
+
+/******************************************************************************
+ ******* static functions (definitions) ***************************************
+ ******************************************************************************/
+/* A gradient (uneven lighting) with dark marks and some noise (see thr.c) */
+static
+void	fill	(uint8_t *buf, ptrdiff_t w, ptrdiff_t h)
+{
+	uint32_t	r;
+	int		v;
+
+	r	= 1;
+	for (ptrdiff_t y = 0; y < h; y++) {
+		for (ptrdiff_t x = 0; x < w; x++) {
+			r	= r * 1103515245 + 12345;
+			v	= 96 + 128 * x / w;
+			if ((x / 64 + y / 64) % 7 == 0)
+				v	-= 64;
+			v	+= (int)(r >> 28) - 8;
+			buf[y * w + x]	= v;
+		}
+	}
+}
+
+static
+double	now	(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return	ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,318 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "ctx.h"
+#include "prof.h"
+#include "reader.h"
+#include "templates/templates.h"
+
+
+/******************************************************************************
+ ******* macro ****************************************************************
+ ******************************************************************************/
+#define WARMUP	(2)
+#define ITERS	(10)
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+struct	Sample {
+	const char	*fname;
+	void		*buf;
+	size_t		size;
+	int		status;
+	uint32_t	codes[MAX_SYMBOLS];
+	ptrdiff_t	n;
+	int64_t		*ns;		/* end to end, every iteration */
+};
+
+/* Time of a stage in every image where it ran (summed over its symbols) */
+struct	Stage {
+	int64_t		*ns;
+	ptrdiff_t	n;
+};
+
+
+/******************************************************************************
+ ******* static functions (prototypes) ****************************************
+ ******************************************************************************/
+static
+int	load	(struct Sample *restrict s, const char *restrict fname);
+static
+void	record	(struct Stage stages[restrict PROF_STAGES],
+		 struct Sample *restrict s, ptrdiff_t it,
+		 const struct Prof *restrict prof);
+static
+void	report	(const struct Sample *restrict samples, ptrdiff_t n,
+		 struct Stage stages[restrict PROF_STAGES],
+		 int warmup, int iters, double wall);
+static
+int64_t	pctl	(int64_t *ns, ptrdiff_t n, int p);
+static
+int	cmp_i64	(const void *a, const void *b);
+static
+double	now	(void);
+
+
+/******************************************************************************
+ ******* main *****************************************************************
+ ******************************************************************************/
+/*
+ * samples [-t <templates dir>] [-w <warmup>] [-n <iterations>] <image>...
+ *
+ * Load the templates and the (encoded) images once, and read every image
+ * warmup + iterations times in a single context, profiling every stage.
+ * The report (stdout) has the result of every image, its median time, and
+ * p50/p95/p99 and images per second of every stage and end to end.  It is
+ * plain text with fixed columns, to be diffed between commits.
+ */
+int	main	(int argc, char *argv[])
+{
+	const char		*dir;
+	struct Templates	*t;
+	struct Ctx		*ctx;
+	struct Sample		*samples;
+	struct Stage		stages[PROF_STAGES];
+	ptrdiff_t		n;
+	int			warmup, iters;
+	int			opt;
+	double			wall;
+	int			status;
+
+	status	= EXIT_FAILURE;
+	dir	= TEMPLATES_DIR;
+	warmup	= WARMUP;
+	iters	= ITERS;
+	while ((opt = getopt(argc, argv, "n:t:w:")) != -1) {
+		switch (opt) {
+		case 'n':
+			iters	= atoi(optarg);
+			break;
+		case 't':
+			dir	= optarg;
+			break;
+		case 'w':
+			warmup	= atoi(optarg);
+			break;
+		default:
+			return	status;
+		}
+	}
+	n	= argc - optind;
+	if (n < 1 || iters < 1 || warmup < 0)
+		return	status;
+
+	samples	= calloc(n, sizeof(*samples));
+	if (!samples)
+		return	status;
+	memset(stages, 0, sizeof(stages));
+	for (ptrdiff_t i = 0; i < PROF_STAGES; i++) {
+		stages[i].ns	= malloc(sizeof(*stages[i].ns) * n * iters);
+		if (!stages[i].ns)
+			goto err0;
+	}
+	for (ptrdiff_t i = 0; i < n; i++) {
+		if (load(&samples[i], argv[optind + i]))
+			goto err0;
+		samples[i].ns	= malloc(sizeof(*samples[i].ns) * iters);
+		if (!samples[i].ns)
+			goto err0;
+	}
+
+	if (init_templates(&t))
+		goto err0;
+	if (load_templates(t, dir))
+		goto err1;
+	if (init_ctx(&ctx, t))
+		goto err1;
+	if (init_prof(&ctx->prof, PROF_WALL))
+		goto err2;
+
+	wall	= now();
+	for (int it = -warmup; it < iters; it++) {
+		if (!it)
+			wall	= now();
+		for (ptrdiff_t i = 0; i < n; i++) {
+			samples[i].status = read_buf(ctx, samples[i].buf,
+						samples[i].size,
+						samples[i].codes, &samples[i].n);
+			if (it >= 0)
+				record(stages, &samples[i], it, ctx->prof);
+			prof_clear(ctx->prof);
+		}
+	}
+	wall	= now() - wall;
+	report(samples, n, stages, warmup, iters, wall);
+
+	status	= EXIT_SUCCESS;
+err2:	deinit_ctx(ctx);
+err1:	deinit_templates(t);
+err0:	for (ptrdiff_t i = 0; i < n; i++) {
+		free(samples[i].ns);
+		free(samples[i].buf);
+	}
+	free(samples);
+	for (ptrdiff_t i = 0; i < PROF_STAGES; i++)
+		free(stages[i].ns);
+	return	status;
+}
+
+
+/******************************************************************************
+ ******* static functions (definitions) ***************************************
+ ******************************************************************************/
+static
+int	load	(struct Sample *restrict s, const char *restrict fname)
+{
+	struct stat	st;
+	FILE		*fp;
+	int		status;
+
+	s->fname	= fname;
+	fp	= fopen(fname, "rb");
+	if (!fp)
+		goto err;
+	status	= -1;
+	if (fstat(fileno(fp), &st) || !st.st_size)
+		goto out;
+	s->size	= st.st_size;
+	s->buf	= malloc(s->size);
+	if (!s->buf)
+		goto out;
+	if (fread(s->buf, 1, s->size, fp) != s->size)
+		goto out;
+	status	= 0;
+out:	fclose(fp);
+	if (!status)
+		return	0;
+err:	fprintf(stderr, "[error]	bench: %s\n", fname);
+	return	-1;
+}
+
+static
+void	record	(struct Stage stages[restrict PROF_STAGES],
+		 struct Sample *restrict s, ptrdiff_t it,
+		 const struct Prof *restrict prof)
+{
+	const struct Prof_Rec	*recs;
+	ptrdiff_t		nrecs;
+	int64_t			ns[PROF_STAGES];
+	bool			ran[PROF_STAGES];
+
+	memset(ns, 0, sizeof(ns));
+	memset(ran, 0, sizeof(ran));
+	recs	= prof_recs(prof, &nrecs);
+	for (ptrdiff_t i = 0; i < nrecs; i++) {
+		ns[recs[i].stage]	+= recs[i].d.ns;
+		ran[recs[i].stage]	= true;
+	}
+	for (ptrdiff_t i = 0; i < PROF_STAGES; i++) {
+		if (ran[i])
+			stages[i].ns[stages[i].n++]	= ns[i];
+	}
+	s->ns[it]	= ns[PROF_TOTAL];
+}
+
+static
+void	report	(const struct Sample *restrict samples, ptrdiff_t n,
+		 struct Stage stages[restrict PROF_STAGES],
+		 int warmup, int iters, double wall)
+{
+	const char	*name;
+	int64_t		sum;
+	ptrdiff_t	m;
+
+	printf("# laundry-symbol-reader bench\n");
+	printf("# images %ti\twarmup %i\titerations %i\n\n", n, warmup, iters);
+
+	printf("%-16s %6s %10s  %s\n", "image", "status", "p50_us", "codes");
+	for (ptrdiff_t i = 0; i < n; i++) {
+		name	= strrchr(samples[i].fname, '/');
+		name	= name ? name + 1 : samples[i].fname;
+		printf("%-16s %6i %10.1f ", name, samples[i].status,
+				pctl(samples[i].ns, iters, 50) / 1e3);
+		for (ptrdiff_t j = 0; j < samples[i].n; j++)
+			printf(" %08"PRIx32, samples[i].codes[j]);
+		putchar('\n');
+	}
+	putchar('\n');
+
+	printf("%-26s %6s %10s %10s %10s %10s\n",
+			"stage", "n", "p50_us", "p95_us", "p99_us", "img/s");
+	for (ptrdiff_t i = 0; i < PROF_STAGES; i++) {
+		m	= stages[i].n;
+		if (!m)
+			continue;
+		sum	= 0;
+		for (ptrdiff_t j = 0; j < m; j++)
+			sum	+= stages[i].ns[j];
+		printf("%-26s %6ti %10.1f %10.1f %10.1f %10.1f\n",
+				prof_stage_names[i], m,
+				pctl(stages[i].ns, m, 50) / 1e3,
+				pctl(stages[i].ns, m, 95) / 1e3,
+				pctl(stages[i].ns, m, 99) / 1e3,
+				sum ? m / (sum / 1e9) : 0);
+	}
+	putchar('\n');
+
+	printf("wall:\t%ti images\t%.3f s\t%.2f img/s\n",
+			n * iters, wall, wall ? n * iters / wall : 0);
+}
+
+/* Nearest rank;  sorts ns[] */
+static
+int64_t	pctl	(int64_t *ns, ptrdiff_t n, int p)
+{
+	ptrdiff_t	i;
+
+	qsort(ns, n, sizeof(*ns), &cmp_i64);
+	i	= (n * p + 99) / 100 - 1;
+	return	ns[i < 0 ? 0 : i];
+}
+
+static
+int	cmp_i64	(const void *a, const void *b)
+{
+	int64_t	x, y;
+
+	x	= *(const int64_t *)a;
+	y	= *(const int64_t *)b;
+	return	(x > y) - (x < y);
+}
+
+static
+double	now	(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return	ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
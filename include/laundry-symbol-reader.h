@@ -0,0 +1,137 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* laundry-symbol-reader.h */
+
+
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * In-process API of laundry-symbol-reader.
+ *
+ * Load the templates once with lsr_templates_init(), create one reader per
+ * thread with lsr_reader_init(), and then read as many labels as needed
+ * with lsr_read_file() or lsr_read_buf().  The templates are only read
+ * after being loaded, so any number of readers may share them; a reader
+ * must not be used by two threads at the same time.
+ *
+ * Every symbol is returned as a packed code:
+ *	bits  1.. 3:	base symbol	(enum Lsr_Base)
+ *	bit   4:	0 if the base symbol is crossed out ("not")
+ *	bits  5..10:	inner meaning	(see lsr_fprint_code())
+ *	bits 11..15:	outer meaning	(number of lines below the symbol)
+ *
+ * lsr_read_*() return 0 on success, or the exit status that the
+ * laundry-symbol-reader program would have had:  4 if the image couldn't
+ * be decoded, and 5 or more if the label couldn't be read (the higher the
+ * number, the further in the pipeline it failed).  Codes of the symbols
+ * read before a failure are still stored.
+ */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+#define LSR_MAX_SYMBOLS		(5)
+
+/* C++ has no restrict; GCC and clang spell it __restrict there */
+#if defined(__cplusplus)
+#define LSR_RESTRICT		__restrict
+#else
+#define LSR_RESTRICT		restrict
+#endif
+
+/* The library is built with -fvisibility=hidden; only lsr_*() are exported */
+#define LSR_API			__attribute__((visibility("default")))
+
+#define LSR_CODE_BASE_POS	(1)
+#define LSR_CODE_BASE_LEN	(3)
+#define LSR_CODE_Y_N_POS	(LSR_CODE_BASE_POS + LSR_CODE_BASE_LEN)
+#define LSR_CODE_IN_POS		(LSR_CODE_Y_N_POS + 1)
+#define LSR_CODE_IN_LEN		(6)
+#define LSR_CODE_OUT_POS	(LSR_CODE_IN_POS + LSR_CODE_IN_LEN)
+#define LSR_CODE_OUT_LEN	(5)
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+enum	Lsr_Base {
+	LSR_BASE_WASH,
+	LSR_BASE_BLEACH,
+	LSR_BASE_DRY,
+	LSR_BASE_IRON,
+	LSR_BASE_PRO
+};
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+struct	Lsr_Templates;
+struct	Lsr_Reader;
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+#if defined(__cplusplus)
+extern	"C" {
+#endif
+
+/* dir may be NULL for the installed templates */
+LSR_API
+int	lsr_templates_init	(struct Lsr_Templates **t, const char *dir);
+LSR_API
+void	lsr_templates_deinit	(struct Lsr_Templates *t);
+
+LSR_API
+int	lsr_reader_init		(struct Lsr_Reader **r,
+				 const struct Lsr_Templates *t);
+LSR_API
+void	lsr_reader_deinit	(struct Lsr_Reader *r);
+
+LSR_API
+int	lsr_read_file		(struct Lsr_Reader *LSR_RESTRICT r,
+				 const char *LSR_RESTRICT fname,
+				 uint32_t codes[LSR_MAX_SYMBOLS],
+				 ptrdiff_t *LSR_RESTRICT n);
+/* buf is an encoded image (JPEG, PNG, ...); it is decoded in place */
+LSR_API
+int	lsr_read_buf		(struct Lsr_Reader *LSR_RESTRICT r,
+				 const void *LSR_RESTRICT buf, size_t size,
+				 uint32_t codes[LSR_MAX_SYMBOLS],
+				 ptrdiff_t *LSR_RESTRICT n);
+
+/* Same text as the laundry-symbol-reader program prints for every symbol */
+LSR_API
+void	lsr_fprint_code		(FILE *stream, uint32_t code);
+
+#if defined(__cplusplus)
+}	/* extern "C" */
+#endif
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,368 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#define _GNU_SOURCE
+#include "batch.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/base/errno.h>
+#include <libalx/base/stdio.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "cache.h"
+#include "ctx.h"
+#include "prof.h"
+#include "reader.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+struct	Batch_Rec {
+	char		*fname;
+	uint32_t	codes[MAX_SYMBOLS];
+	ptrdiff_t	n;
+	int		status;
+	bool		done;
+};
+
+struct	Batch {
+	const struct Templates	*t;
+	int			prof;
+	const char		*cache;
+	struct Batch_Rec	*recs;
+	ptrdiff_t		n;
+	ptrdiff_t		size;
+	atomic_ptrdiff_t	next;
+	pthread_mutex_t		mutex;
+	pthread_cond_t		cond;
+};
+
+struct	Worker {
+	struct Batch	*b;
+	pthread_t	thr;
+	ptrdiff_t	n;
+	double		busy;
+	int		status;
+};
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+int	list_add	(struct Batch *restrict b, const char *restrict fname);
+static
+int	list_dir	(struct Batch *restrict b, const char *restrict dir);
+static
+int	list_stream	(struct Batch *restrict b, FILE *restrict stream);
+static
+int	dir_filter	(const struct dirent *ent);
+static
+void	*worker		(void *arg);
+static
+void	read_rec	(struct Ctx *restrict ctx,
+			 struct Batch_Rec *restrict rec);
+static
+void	report		(const struct Worker *restrict w, int nthr,
+			 double wall);
+static
+double	now		(void);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+/*
+ * Read every image in paths[]:  a path may be an image, a directory (its
+ * files, but hidden ones, are read in alphabetical order), or "-" (a list
+ * of images, one per line, is read from stdin).  No paths at all is the
+ * same as "-".
+ *
+ * The images are read by nthr threads (one per online CPU if nthr is 0),
+ * each with its own context, all sharing the templates.  A record is printed
+ * for every image (see print_result()) in the order of the input, and a
+ * failure to read one image doesn't stop the batch.  The throughput of every
+ * thread is reported to stderr.  With a cache (a file name, or NULL), every
+ * thread opens it on its own (see init_cache()), or reads without it if it
+ * can't.
+ */
+int	batch		(const struct Templates *restrict t, int nthr, int prof,
+			 const char *restrict cache,
+			 char *const paths[], ptrdiff_t n)
+{
+	struct Batch	b;
+	struct Worker	*w;
+	struct stat	st;
+	double		wall;
+	int		i;
+	int		status;
+
+	b.t	= t;
+	b.prof	= prof;
+	b.cache	= cache;
+	b.recs	= NULL;
+	b.n	= 0;
+	b.size	= 0;
+	atomic_init(&b.next, 0);
+
+	status	= -1;
+	if (!n && list_stream(&b, stdin))
+		goto err0;
+	for (ptrdiff_t j = 0; j < n; j++) {
+		if (!strcmp(paths[j], "-")) {
+			if (list_stream(&b, stdin))
+				goto err0;
+		} else if (!stat(paths[j], &st) && S_ISDIR(st.st_mode)) {
+			if (list_dir(&b, paths[j]))
+				goto err0;
+		} else {
+			if (list_add(&b, paths[j]))
+				goto err0;
+		}
+	}
+
+	if (!nthr)
+		nthr	= sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthr > b.n)
+		nthr	= b.n;
+	if (nthr < 1)
+		nthr	= 1;
+	w	= calloc(nthr, sizeof(*w));
+	if (!w)
+		goto err0;
+	if (pthread_mutex_init(&b.mutex, NULL))
+		goto err1;
+	if (pthread_cond_init(&b.cond, NULL))
+		goto err2;
+
+	wall	= now();
+	for (i = 0; i < nthr; i++) {
+		w[i].b	= &b;
+		if (pthread_create(&w[i].thr, NULL, &worker, &w[i]))
+			break;
+	}
+	nthr	= i;
+	if (nthr)
+		status	= 0;
+	for (ptrdiff_t j = 0; nthr && j < b.n; j++) {
+		pthread_mutex_lock(&b.mutex);
+		while (!b.recs[j].done)
+			pthread_cond_wait(&b.cond, &b.mutex);
+		pthread_mutex_unlock(&b.mutex);
+		print_result(stdout, b.recs[j].fname, b.recs[j].status,
+					b.recs[j].codes, b.recs[j].n);
+	}
+	for (i = 0; i < nthr; i++) {
+		pthread_join(w[i].thr, NULL);
+		if (w[i].status)
+			status	= -1;
+	}
+	wall	= now() - wall;
+	report(w, nthr, wall);
+
+	pthread_cond_destroy(&b.cond);
+err2:	pthread_mutex_destroy(&b.mutex);
+err1:	free(w);
+err0:	for (ptrdiff_t j = 0; j < b.n; j++)
+		free(b.recs[j].fname);
+	free(b.recs);
+	return	status;
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+static
+int	list_add	(struct Batch *restrict b, const char *restrict fname)
+{
+	struct Batch_Rec	*recs;
+
+	if (b->n == b->size) {
+		b->size	= b->size ? b->size * 2 : 64;
+		recs	= reallocarray(b->recs, b->size, sizeof(*recs));
+		if (!recs)
+			return	-1;
+		b->recs	= recs;
+	}
+	memset(&b->recs[b->n], 0, sizeof(b->recs[b->n]));
+	b->recs[b->n].fname	= strdup(fname);
+	if (!b->recs[b->n].fname)
+		return	-1;
+	b->n++;
+
+	return	0;
+}
+
+static
+int	list_dir	(struct Batch *restrict b, const char *restrict dir)
+{
+	struct dirent	**ents;
+	char		fname[FILENAME_MAX];
+	int		n;
+	int		status;
+
+	n	= scandir(dir, &ents, &dir_filter, &alphasort);
+	if (n < 0) {
+		perrorx("[error]	scandir(%s)\n", dir);
+		return	-1;
+	}
+
+	status	= 0;
+	for (int i = 0; i < n; i++) {
+		if (!status) {
+			if (sbprintf(fname, NULL, "%s/%s", dir, ents[i]->d_name))
+				status	= -1;
+			else
+				status	= list_add(b, fname);
+		}
+		free(ents[i]);
+	}
+	free(ents);
+
+	return	status;
+}
+
+static
+int	list_stream	(struct Batch *restrict b, FILE *restrict stream)
+{
+	char	*line;
+	size_t	sz;
+	ssize_t	len;
+	int	status;
+
+	line	= NULL;
+	sz	= 0;
+	status	= 0;
+	while ((len = getline(&line, &sz, stream)) >= 0) {
+		if (len && line[len - 1] == '\n')
+			line[--len]	= '\0';
+		if (!len)
+			continue;
+		status	= list_add(b, line);
+		if (status)
+			break;
+	}
+	free(line);
+
+	return	ferror(stream) ? -1 : status;
+}
+
+/* Regular files and links (or unknown types), but not hidden ones */
+static
+int	dir_filter	(const struct dirent *ent)
+{
+
+	if (ent->d_name[0] == '.')
+		return	0;
+	if (ent->d_type == DT_UNKNOWN)
+		return	1;
+	return	ent->d_type == DT_REG || ent->d_type == DT_LNK;
+}
+
+static
+void	*worker		(void *arg)
+{
+	struct Worker	*w;
+	struct Batch	*b;
+	struct Ctx	*ctx;
+	ptrdiff_t	i;
+	double		t0;
+
+	w	= arg;
+	b	= w->b;
+	w->status	= init_ctx(&ctx, b->t);
+	if (!w->status && init_prof(&ctx->prof, b->prof)) {
+		deinit_ctx(ctx);
+		w->status	= -1;
+	}
+	/* Optional (see main()) */
+	if (!w->status)
+		init_cache(&ctx->cache, b->cache, b->t);
+
+	while ((i = atomic_fetch_add(&b->next, 1)) < b->n) {
+		t0	= now();
+		if (w->status)
+			b->recs[i].status	= 2;
+		else
+			read_rec(ctx, &b->recs[i]);
+		w->busy	+= now() - t0;
+		w->n++;
+
+		pthread_mutex_lock(&b->mutex);
+		b->recs[i].done	= true;
+		pthread_cond_broadcast(&b->cond);
+		pthread_mutex_unlock(&b->mutex);
+	}
+
+	if (!w->status)
+		deinit_ctx(ctx);
+	return	NULL;
+}
+
+static
+void	read_rec	(struct Ctx *restrict ctx,
+			 struct Batch_Rec *restrict rec)
+{
+
+	rec->status	= read_file(ctx, rec->fname, rec->codes, &rec->n);
+	prof_fprint(stderr, ctx->prof, rec->fname);
+}
+
+static
+void	report		(const struct Worker *restrict w, int nthr,
+			 double wall)
+{
+	ptrdiff_t	n;
+
+	n	= 0;
+	for (int i = 0; i < nthr; i++) {
+		fprintf(stderr, "thread %i:\t%ti images\t%.3f s\t%.2f img/s\n",
+				i, w[i].n, w[i].busy,
+				w[i].busy ? w[i].n / w[i].busy : 0);
+		n	+= w[i].n;
+	}
+	fprintf(stderr, "total:\t%ti images\t%.3f s\t%.2f img/s\t%i threads\n",
+			n, wall, wall ? n / wall : 0, nthr);
+}
+
+static
+double	now		(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return	ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,205 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "bits.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "pool.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+#define BITS_WORD	(64)
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+uint64_t	xor_popcnt	(const uint64_t *restrict a,
+				 const uint64_t *restrict b, ptrdiff_t n);
+static
+uint64_t	xor_popcnt_64	(const uint64_t *restrict a,
+				 const uint64_t *restrict b, ptrdiff_t n);
+#if defined(__x86_64__)
+static
+uint64_t	xor_popcnt_avx2	(const uint64_t *restrict a,
+				 const uint64_t *restrict b, ptrdiff_t n);
+#endif
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+size_t	bits_size	(ptrdiff_t w, ptrdiff_t h)
+{
+
+	return	sizeof(uint64_t) * ((w + BITS_WORD - 1) / BITS_WORD) * h;
+}
+
+/* Zeroed, in scratch memory (see pool.h) */
+int	bits_init	(struct Bits *b, ptrdiff_t w, ptrdiff_t h)
+{
+	void	*data;
+
+	data	= pool_get_buf(bits_size(w, h));
+	if (!data)
+		return	-1;
+	memset(data, 0, bits_size(w, h));
+	bits_init_buf(b, data, w, h);
+	return	0;
+}
+
+/* In data, of bits_size(w, h) bytes, which the caller keeps (uninitialized) */
+void	bits_init_buf	(struct Bits *restrict b, void *restrict data,
+			 ptrdiff_t w, ptrdiff_t h)
+{
+
+	b->w	= w;
+	b->h	= h;
+	b->wpl	= (w + BITS_WORD - 1) / BITS_WORD;
+	b->data	= data;
+}
+
+void	bits_deinit	(struct Bits *b)
+{
+
+	pool_put_buf(b->data);
+}
+
+/*
+ * Pack img (8-bit, single channel;  nonzero is 1) into b, resized to the
+ * size of b (nearest neighbour).
+ */
+int	bits_pack	(struct Bits *restrict b, const img_s *restrict img)
+{
+	const uint8_t	*data, *row;
+	void		*d;
+	ptrdiff_t	w, h, B_per_pix, B_per_line;
+	uint64_t	*line;
+
+	alx_cv_extract_imgdata(img, &d, &w, &h, &B_per_pix, &B_per_line, NULL);
+	if (B_per_pix != 1 || !w || !h)
+		return	-1;
+	data	= d;
+
+	for (ptrdiff_t y = 0; y < b->h; y++) {
+		row	= data + (y * h / b->h) * B_per_line;
+		line	= b->data + y * b->wpl;
+		memset(line, 0, b->wpl * sizeof(*line));
+		for (ptrdiff_t x = 0; x < b->w; x++) {
+			if (row[x * w / b->w])
+				line[x / BITS_WORD] |= UINT64_C(1) << (x % BITS_WORD);
+		}
+	}
+	return	0;
+}
+
+/* (Fraction of equal pixels) ^ power;  a and b have the same size */
+double	bits_match	(const struct Bits *a, const struct Bits *b, int power)
+{
+	uint64_t	diff;
+	double		total;
+
+	total	= a->w * a->h;
+	diff	= xor_popcnt(a->data, b->data, a->wpl * a->h);
+	return	pow((total - diff) / total, power);
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+static
+uint64_t	xor_popcnt	(const uint64_t *restrict a,
+				 const uint64_t *restrict b, ptrdiff_t n)
+{
+
+#if defined(__x86_64__)
+	if (__builtin_cpu_supports("avx2"))
+		return	xor_popcnt_avx2(a, b, n);
+#endif
+	return	xor_popcnt_64(a, b, n);
+}
+
+__attribute__((target_clones("popcnt", "default")))
+static
+uint64_t	xor_popcnt_64	(const uint64_t *restrict a,
+				 const uint64_t *restrict b, ptrdiff_t n)
+{
+	uint64_t	cnt;
+
+	cnt	= 0;
+	for (ptrdiff_t i = 0; i < n; i++)
+		cnt	+= __builtin_popcountll(a[i] ^ b[i]);
+	return	cnt;
+}
+
+#if defined(__x86_64__)
+/*
+ * Population count of 256 bits at a time:  a lookup of every nibble with
+ * vpshufb, and the bytes added up with vpsadbw (Muła et al.).
+ */
+__attribute__((target("avx2,popcnt")))
+static
+uint64_t	xor_popcnt_avx2	(const uint64_t *restrict a,
+				 const uint64_t *restrict b, ptrdiff_t n)
+{
+	const __m256i	lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+						1, 2, 2, 3, 2, 3, 3, 4,
+						0, 1, 1, 2, 1, 2, 2, 3,
+						1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i	low = _mm256_set1_epi8(0x0F);
+	__m256i		acc, x, lo, hi;
+	uint64_t	cnt;
+	ptrdiff_t	i;
+
+	acc	= _mm256_setzero_si256();
+	for (i = 0; i + 4 <= n; i += 4) {
+		x	= _mm256_xor_si256(
+				_mm256_loadu_si256((const __m256i *)&a[i]),
+				_mm256_loadu_si256((const __m256i *)&b[i]));
+		lo	= _mm256_shuffle_epi8(lut, _mm256_and_si256(x, low));
+		hi	= _mm256_shuffle_epi8(lut,
+				_mm256_and_si256(_mm256_srli_epi16(x, 4), low));
+		acc	= _mm256_add_epi64(acc, _mm256_sad_epu8(
+				_mm256_add_epi8(lo, hi),
+				_mm256_setzero_si256()));
+	}
+	cnt	= _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1)
+		+ _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+	for (; i < n; i++)
+		cnt	+= __builtin_popcountll(a[i] ^ b[i]);
+	return	cnt;
+}
+#endif
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,72 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* bits.h */
+
+
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * Binary masks packed 1 bit per pixel, 64 pixels per word, every line padded
+ * with 0s to a whole number of words.  Two masks are compared by XOR and a
+ * population count, 64 (or, with AVX2, 256) pixels at a time.
+ */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libalx/extra/cv/cv.h>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+struct	Bits {
+	uint64_t	*data;
+	ptrdiff_t	w;
+	ptrdiff_t	h;
+	ptrdiff_t	wpl;	/* words per line */
+};
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+size_t	bits_size	(ptrdiff_t w, ptrdiff_t h);
+int	bits_init	(struct Bits *b, ptrdiff_t w, ptrdiff_t h);
+void	bits_init_buf	(struct Bits *restrict b, void *restrict data,
+			 ptrdiff_t w, ptrdiff_t h);
+void	bits_deinit	(struct Bits *b);
+int	bits_pack	(struct Bits *restrict b, const img_s *restrict img);
+double	bits_match	(const struct Bits *a, const struct Bits *b, int power);
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,388 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#define _GNU_SOURCE
+#include "cache.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <link.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/base/errno.h>
+
+#include "ctx.h"
+#include "hash.h"
+#include "templates/templates.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+#define CACHE_MAGIC	"LSR-CCH"
+/* Of the format of the file;  the program itself is told by build_id() */
+#define CACHE_VERSION	(2)
+/* 32 Ki entries of 64 B (2 MiB);  an image can be in any of the ways of 1 set */
+#define CACHE_SETS	(4096)
+#define CACHE_WAYS	(8)
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+/* Empty if tick is 0 */
+struct	Cache_Entry {
+	uint64_t	key[2];
+	uint64_t	size;
+	uint64_t	tick;
+	int32_t		status;
+	int32_t		n;
+	uint32_t	codes[MAX_SYMBOLS];
+	uint32_t	pad[3];
+};
+
+/* The ticks count the accesses;  the oldest entry of a set is replaced */
+struct	Cache_Hdr {
+	char			magic[8];
+	uint32_t		version;
+	uint32_t		sets;
+	uint32_t		ways;
+	uint32_t		entry_size;
+	uint64_t		templates[2];
+	uint64_t		build[2];
+	uint64_t		tick;
+	uint64_t		pad;
+	struct Cache_Entry	e[];
+};
+
+struct	Cache {
+	int			fd;
+	struct Cache_Hdr	*hdr;
+	size_t			map_size;
+	uint64_t		templates[2];
+	uint64_t		build[2];
+	/* The image of the last cache_get(), for cache_put() */
+	uint64_t		key[2];
+	uint64_t		size;
+};
+
+
+/******************************************************************************
+ ******* variables ************************************************************
+ ******************************************************************************/
+static pthread_once_t	build_once	= PTHREAD_ONCE_INIT;
+static uint64_t		build[2];
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+void	build_id	(void);
+static
+int	build_id_seg	(struct dl_phdr_info *info, size_t size, void *data);
+static
+bool	hdr_ok		(const struct Cache *cache);
+static
+void	hdr_reset	(const struct Cache *cache);
+static
+struct Cache_Entry *find	(const struct Cache *cache);
+static
+struct Cache_Entry *victim	(const struct Cache *cache);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+/*
+ * Open (creating it if needed) the cache in fname, for results read with the
+ * templates t, by this build of the program (see build_id()).  If they are
+ * other ones, the table is emptied.  With no fname, *cache is NULL, and
+ * nothing is cached.  A file of another size is refused:  it may be mapped
+ * by some process, which would fault if it shrank.
+ *
+ * Every context opens the file on its own, because the table is locked with
+ * flock(2), which excludes open file descriptions, not processes;  that way
+ * the contexts of one process exclude each other too.
+ */
+int	init_cache	(struct Cache **restrict cache,
+			 const char *restrict fname,
+			 const struct Templates *restrict t)
+{
+	struct Cache	*c;
+	struct stat	st;
+	void		*map;
+
+	*cache	= NULL;
+	if (!fname)
+		return	0;
+	c	= calloc(1, sizeof(*c));
+	if (!c)
+		return	-1;
+	c->map_size	= sizeof(*c->hdr) +
+			CACHE_SETS * CACHE_WAYS * sizeof(c->hdr->e[0]);
+	memcpy(c->templates, t->version, sizeof(c->templates));
+	pthread_once(&build_once, &build_id);
+	memcpy(c->build, build, sizeof(c->build));
+	c->fd	= open(fname, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (c->fd < 0)
+		goto err0;
+	if (flock(c->fd, LOCK_EX))
+		goto err1;
+	if (fstat(c->fd, &st))
+		goto err2;
+	/* Just created (with zeros) */
+	if (!st.st_size && ftruncate(c->fd, c->map_size))
+		goto err2;
+	if (st.st_size && (size_t)st.st_size != c->map_size) {
+		errno	= EINVAL;
+		goto err2;
+	}
+	map	= mmap(NULL, c->map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+								c->fd, 0);
+	if (map == MAP_FAILED)
+		goto err2;
+	c->hdr	= map;
+	if (!hdr_ok(c))
+		hdr_reset(c);
+	flock(c->fd, LOCK_UN);
+
+	*cache	= c;
+	return	0;
+
+err2:	flock(c->fd, LOCK_UN);
+err1:	close(c->fd);
+err0:	perrorx("[warning]	cache: %s\n", fname);
+	free(c);
+	return	-1;
+}
+
+void	deinit_cache	(struct Cache *cache)
+{
+
+	if (!cache)
+		return;
+	munmap(cache->hdr, cache->map_size);
+	close(cache->fd);
+	free(cache);
+}
+
+/*
+ * Look up the image in buf, and remember it for cache_put().  Returns the
+ * status it was read with (its codes are copied into codes[0 .. *n)), or -1
+ * if it's not there.
+ */
+int	cache_get	(struct Cache *restrict cache,
+			 const void *restrict buf, size_t size,
+			 uint32_t codes[MAX_SYMBOLS], ptrdiff_t *restrict n)
+{
+	struct Cache_Entry	*e;
+	int			status;
+
+	*n	= 0;
+	if (!cache)
+		return	-1;
+	hash128(cache->key, buf, size);
+	cache->size	= size;
+
+	if (flock(cache->fd, LOCK_EX))
+		return	-1;
+	status	= -1;
+	if (!hdr_ok(cache))
+		goto out;
+	e	= find(cache);
+	if (!e)
+		goto out;
+	e->tick	= ++cache->hdr->tick;
+	status	= e->status;
+	*n	= MIN(e->n, MAX_SYMBOLS);
+	memcpy(codes, e->codes, sizeof(codes[0]) * *n);
+out:	flock(cache->fd, LOCK_UN);
+	return	status;
+}
+
+/*
+ * Store the result of the image of the last cache_get().  Only images that
+ * were read entirely are stored:  a failure may not happen again (e.g., if
+ * it was the lack of memory).
+ */
+void	cache_put	(struct Cache *restrict cache, int status,
+			 const uint32_t codes[MAX_SYMBOLS], ptrdiff_t n)
+{
+	struct Cache_Entry	*e;
+
+	if (!cache || status)
+		return;
+	if (flock(cache->fd, LOCK_EX))
+		return;
+	/* Another process may have emptied it for its own templates or build */
+	if (!hdr_ok(cache))
+		goto out;
+	e	= find(cache);
+	if (!e)
+		e	= victim(cache);
+
+	/* If the process dies halfway, the entry is left empty */
+	e->tick	= 0;
+	atomic_signal_fence(memory_order_seq_cst);
+	memcpy(e->key, cache->key, sizeof(e->key));
+	e->size		= cache->size;
+	e->status	= status;
+	e->n		= MIN(n, MAX_SYMBOLS);
+	memset(e->codes, 0, sizeof(e->codes));
+	memcpy(e->codes, codes, sizeof(codes[0]) * e->n);
+	atomic_signal_fence(memory_order_seq_cst);
+	e->tick	= ++cache->hdr->tick;
+out:	flock(cache->fd, LOCK_UN);
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+/*
+ * A hash of the read-only segments (code and constants) of the object that
+ * has the reader in it:  the library, or the program it's linked into.  Any
+ * change to the pipeline, its tables, or the options it was compiled with
+ * changes it, without anyone having to remember to bump a version.  The
+ * libraries it uses (libalx, OpenCV, libjpeg) are not covered.
+ */
+static
+void	build_id	(void)
+{
+	uint64_t	h[2];
+
+	h[0]	= 0;
+	h[1]	= 0;
+	dl_iterate_phdr(&build_id_seg, h);
+	memcpy(build, h, sizeof(build));
+}
+
+/* If info is the object of build_id(), hash its segments into data */
+static
+int	build_id_seg	(struct dl_phdr_info *info, size_t size, void *data)
+{
+	const ElfW(Phdr)	*ph;
+	uintptr_t		self, start;
+	uint64_t		(*h)[2];
+	uint64_t		acc[2][2];
+	bool			found;
+
+	(void)size;
+	self	= (uintptr_t)&build_id;
+	found	= false;
+	for (ptrdiff_t i = 0; i < info->dlpi_phnum; i++) {
+		ph	= &info->dlpi_phdr[i];
+		start	= info->dlpi_addr + ph->p_vaddr;
+		if (ph->p_type == PT_LOAD &&
+				self >= start && self - start < ph->p_memsz)
+			found	= true;
+	}
+	if (!found)
+		return	0;
+
+	h	= data;
+	for (ptrdiff_t i = 0; i < info->dlpi_phnum; i++) {
+		ph	= &info->dlpi_phdr[i];
+		if (ph->p_type != PT_LOAD || ph->p_flags & PF_W ||
+						!(ph->p_flags & PF_R))
+			continue;
+#if defined(__SANITIZE_ADDRESS__)
+		/* ASan poisons the space between constants;  code only */
+		if (!(ph->p_flags & PF_X))
+			continue;
+#endif
+		memcpy(acc[0], *h, sizeof(acc[0]));
+		hash128(acc[1], (const void *)(info->dlpi_addr + ph->p_vaddr),
+								ph->p_filesz);
+		hash128(*h, acc, sizeof(acc));
+	}
+	return	1;
+}
+
+static
+bool	hdr_ok		(const struct Cache *cache)
+{
+	const struct Cache_Hdr	*hdr;
+
+	hdr	= cache->hdr;
+	return	!memcmp(hdr->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) &&
+		hdr->version == CACHE_VERSION &&
+		hdr->sets == CACHE_SETS &&
+		hdr->ways == CACHE_WAYS &&
+		hdr->entry_size == sizeof(hdr->e[0]) &&
+		!memcmp(hdr->templates, cache->templates, sizeof(hdr->templates)) &&
+		!memcmp(hdr->build, cache->build, sizeof(hdr->build));
+}
+
+static
+void	hdr_reset	(const struct Cache *cache)
+{
+	struct Cache_Hdr	*hdr;
+
+	hdr	= cache->hdr;
+	memset(hdr->e, 0, CACHE_SETS * CACHE_WAYS * sizeof(hdr->e[0]));
+	memcpy(hdr->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	hdr->version	= CACHE_VERSION;
+	hdr->sets	= CACHE_SETS;
+	hdr->ways	= CACHE_WAYS;
+	hdr->entry_size	= sizeof(hdr->e[0]);
+	memcpy(hdr->templates, cache->templates, sizeof(hdr->templates));
+	memcpy(hdr->build, cache->build, sizeof(hdr->build));
+	hdr->tick	= 0;
+}
+
+/* The entry of the image of the last cache_get(), if it's there */
+static
+struct Cache_Entry *find	(const struct Cache *cache)
+{
+	struct Cache_Entry	*set;
+
+	set	= &cache->hdr->e[cache->key[0] % CACHE_SETS * CACHE_WAYS];
+	for (ptrdiff_t i = 0; i < CACHE_WAYS; i++) {
+		if (set[i].tick && set[i].size == cache->size &&
+				!memcmp(set[i].key, cache->key, sizeof(set[i].key)))
+			return	&set[i];
+	}
+	return	NULL;
+}
+
+/* An empty entry of its set, or else the least recently used one */
+static
+struct Cache_Entry *victim	(const struct Cache *cache)
+{
+	struct Cache_Entry	*set, *lru;
+
+	set	= &cache->hdr->e[cache->key[0] % CACHE_SETS * CACHE_WAYS];
+	lru	= &set[0];
+	for (ptrdiff_t i = 1; i < CACHE_WAYS; i++) {
+		if (set[i].tick < lru->tick)
+			lru	= &set[i];
+	}
+	return	lru;
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
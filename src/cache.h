@@ -0,0 +1,73 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* cache.h */
+
+
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * Results of images already read, kept in a file of fixed size that is
+ * mapped by every process (and context) that uses it.  An image is found by
+ * a hash of its encoded bytes, so that uploading the same photo again
+ * doesn't even decode it.  The results are only valid for the templates,
+ * and the build of the program, that they were read with:  with others, the
+ * table is emptied.
+ */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ctx.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+struct	Cache;
+struct	Templates;
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+int	init_cache	(struct Cache **restrict cache,
+			 const char *restrict fname,
+			 const struct Templates *restrict t);
+void	deinit_cache	(struct Cache *cache);
+int	cache_get	(struct Cache *restrict cache,
+			 const void *restrict buf, size_t size,
+			 uint32_t codes[MAX_SYMBOLS], ptrdiff_t *restrict n);
+void	cache_put	(struct Cache *restrict cache, int status,
+			 const uint32_t codes[MAX_SYMBOLS], ptrdiff_t n);
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
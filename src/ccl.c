@@ -0,0 +1,585 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#define _GNU_SOURCE
+#include "ccl.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/param.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "pool.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+struct	Ccl_Run {
+	int32_t	x0, x1;	/* [x0, x1) */
+	int32_t	y;
+	int32_t	lbl;
+	bool	fg;
+};
+
+enum	Ccl_Holes {
+	CCL_HOLES_FILL,
+	CCL_HOLES_REMOVE,
+	CCL_HOLES_EXTRACT
+};
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+int	reserve		(struct Ccl *ccl, ptrdiff_t n);
+static
+int32_t	uf_find		(int32_t *uf, int32_t i);
+static
+void	uf_union	(int32_t *uf, int32_t i, int32_t j);
+static
+ptrdiff_t scan		(struct Ccl *restrict ccl, const uint8_t *restrict data,
+			 ptrdiff_t step);
+static
+int	stats		(struct Ccl *ccl, ptrdiff_t nruns);
+static
+void	perimeters	(struct Ccl *ccl, ptrdiff_t nruns);
+static
+int	img_data	(const img_s *restrict img, uint8_t **restrict data,
+			 ptrdiff_t *restrict w, ptrdiff_t *restrict h,
+			 ptrdiff_t *restrict step);
+static
+int	holes		(img_s *img, int op);
+static
+int	cmp_x		(const void *a, const void *b, void *ccl);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+int	init_ccl	(struct Ccl **ccl)
+{
+	struct Ccl	*c;
+
+	c	= calloc(1, sizeof(*c));
+	if (!c)
+		return	-1;
+	*ccl	= c;
+	return	0;
+}
+
+void	deinit_ccl	(struct Ccl *ccl)
+{
+
+	free(ccl->comp);
+	free(ccl->uf);
+	free(ccl->runs);
+	free(ccl->lbl);
+	free(ccl);
+}
+
+/*
+ * Label img in ccl.  The runs of every line are joined (union-find) to the
+ * overlapping runs of the line above of the same kind;  the statistics are
+ * then gathered run by run, except the perimeter, which needs the labels of
+ * the neighbours of every pixel.
+ */
+int	ccl_label	(struct Ccl *restrict ccl, const img_s *restrict img)
+{
+	uint8_t		*data;
+	int32_t		*lbl;
+	ptrdiff_t	step;
+	ptrdiff_t	nruns;
+
+	if (img_data(img, &data, &ccl->w, &ccl->h, &step))
+		return	-1;
+	if (ccl->w * ccl->h > ccl->lbl_size) {
+		lbl	= reallocarray(ccl->lbl, ccl->w * ccl->h, sizeof(*lbl));
+		if (!lbl)
+			return	-1;
+		ccl->lbl	= lbl;
+		ccl->lbl_size	= ccl->w * ccl->h;
+	}
+
+	nruns	= scan(ccl, data, step);
+	if (nruns < 0)
+		return	-1;
+	if (stats(ccl, nruns))
+		return	-1;
+	perimeters(ccl, nruns);
+	return	0;
+}
+
+/* A foreground component that isn't inside a hole of another one */
+bool	ccl_is_outer	(const struct Ccl *ccl, ptrdiff_t i)
+{
+	ptrdiff_t	p;
+
+	if (!ccl->comp[i].fg)
+		return	false;
+	p	= ccl->comp[i].parent;
+	return	p < 0 || ccl->comp[p].border;
+}
+
+/*
+ * Store in idx[] (up to size) the outer foreground components, from left to
+ * right, and return how many there are (as many as external contours).
+ */
+ptrdiff_t ccl_outer	(const struct Ccl *restrict ccl,
+			 ptrdiff_t *restrict idx, ptrdiff_t size)
+{
+	ptrdiff_t	n;
+
+	n	= 0;
+	for (ptrdiff_t i = 0; i < ccl->n; i++) {
+		if (!ccl_is_outer(ccl, i))
+			continue;
+		if (n < size)
+			idx[n]	= i;
+		n++;
+	}
+	if (idx)
+		qsort_r(idx, MIN(n, size), sizeof(*idx), &cmp_x, (void *)ccl);
+	return	n;
+}
+
+/* Like the largest contour by area:  holes count as part of the blob */
+ptrdiff_t ccl_largest_a	(const struct Ccl *ccl)
+{
+	ptrdiff_t	j;
+
+	j	= -1;
+	for (ptrdiff_t i = 0; i < ccl->n; i++) {
+		if (!ccl_is_outer(ccl, i))
+			continue;
+		if (j < 0 || ccl->comp[i].area_f > ccl->comp[j].area_f)
+			j	= i;
+	}
+	return	j;
+}
+
+ptrdiff_t ccl_largest_p	(const struct Ccl *ccl)
+{
+	ptrdiff_t	j;
+
+	j	= -1;
+	for (ptrdiff_t i = 0; i < ccl->n; i++) {
+		if (!ccl_is_outer(ccl, i))
+			continue;
+		if (j < 0 || ccl->comp[i].perim > ccl->comp[j].perim)
+			j	= i;
+	}
+	return	j;
+}
+
+/* The outer component (with its holes) with a pixel closest to (x, y) */
+ptrdiff_t ccl_closest	(const struct Ccl *ccl, ptrdiff_t x, ptrdiff_t y)
+{
+	ptrdiff_t	*root;
+	ptrdiff_t	j, r, d, dmin;
+
+	root	= pool_get_buf(sizeof(*root) * (ccl->n + 1));
+	if (!root)
+		return	-1;
+	for (ptrdiff_t i = 0; i < ccl->n; i++) {
+		if (ccl_is_outer(ccl, i))
+			root[i]	= i;
+		else if (ccl->comp[i].parent < 0)
+			root[i]	= -1;
+		else
+			root[i]	= root[ccl->comp[i].parent];
+	}
+
+	j	= -1;
+	dmin	= PTRDIFF_MAX;
+	for (ptrdiff_t v = 0; v < ccl->h; v++) {
+		for (ptrdiff_t u = 0; u < ccl->w; u++) {
+			r	= root[ccl->lbl[v * ccl->w + u]];
+			if (r < 0)
+				continue;
+			d	= (u - x) * (u - x) + (v - y) * (v - y);
+			if (d < dmin) {
+				dmin	= d;
+				j	= r;
+			}
+		}
+	}
+
+	pool_put_buf(root);
+	return	j;
+}
+
+/* The outer component that encloses i (or i itself), or -1 if none does */
+ptrdiff_t ccl_outer_of	(const struct Ccl *ccl, ptrdiff_t i)
+{
+
+	while (i >= 0 && !ccl_is_outer(ccl, i))
+		i	= ccl->comp[i].parent;
+	return	i;
+}
+
+int	ccl_bounding_rect(rect_s *restrict rect,
+			 const struct Ccl *restrict ccl, ptrdiff_t i)
+{
+	const struct Ccl_Comp	*c;
+
+	c	= &ccl->comp[i];
+	return	alx_cv_set_rect(rect, c->x, c->y, c->w, c->h);
+}
+
+/*
+ * Draw component i, filled (like its contour), in img, which has the size of
+ * the labeled image.
+ */
+int	ccl_mask	(img_s *restrict img,
+			 const struct Ccl *restrict ccl, ptrdiff_t i)
+{
+	bool		*in;
+	ptrdiff_t	p;
+	int		status;
+
+	in	= pool_get_buf(sizeof(*in) * ccl->n);
+	if (!in)
+		return	-1;
+	memset(in, 0, sizeof(*in) * ccl->n);
+	for (ptrdiff_t k = i; k < ccl->n; k++) {
+		p	= ccl->comp[k].parent;
+		in[k]	= k == i || (p >= 0 && in[p]);
+	}
+	status	= ccl_select(img, ccl, in);
+
+	pool_put_buf(in);
+	return	status;
+}
+
+/* Draw in img the pixels of the components i for which on[i] is true */
+int	ccl_select	(img_s *restrict img, const struct Ccl *restrict ccl,
+			 const bool *restrict on)
+{
+	uint8_t		*data;
+	ptrdiff_t	w, h, step;
+
+	if (img_data(img, &data, &w, &h, &step))
+		return	-1;
+	if (w != ccl->w || h != ccl->h)
+		return	-1;
+
+	for (ptrdiff_t y = 0; y < h; y++) {
+		for (ptrdiff_t x = 0; x < w; x++)
+			data[y * step + x] = on[ccl->lbl[y * w + x]] ? UINT8_MAX : 0;
+	}
+	return	0;
+}
+
+/* Drop-ins for alx_cv_holes_*() */
+void	ccl_holes_fill	(img_s *img)
+{
+
+	if (holes(img, CCL_HOLES_FILL))
+		alx_cv_holes_fill(img);
+}
+
+/* Keep the outer components (remove anything inside their holes) */
+void	ccl_holes_remove(img_s *img)
+{
+
+	if (holes(img, CCL_HOLES_REMOVE))
+		alx_cv_holes_remove(img);
+}
+
+/* Keep only what is inside the holes */
+void	ccl_holes_extract(img_s *img)
+{
+
+	if (holes(img, CCL_HOLES_EXTRACT))
+		alx_cv_holes_extract(img);
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+static
+int	reserve		(struct Ccl *ccl, ptrdiff_t n)
+{
+	struct Ccl_Run	*runs;
+	int32_t		*uf;
+
+	if (n <= ccl->size)
+		return	0;
+	n	= MAX(n, ccl->size * 2);
+	runs	= reallocarray(ccl->runs, n, sizeof(*runs));
+	if (!runs)
+		return	-1;
+	ccl->runs	= runs;
+	uf	= reallocarray(ccl->uf, n, sizeof(*uf));
+	if (!uf)
+		return	-1;
+	ccl->uf		= uf;
+	ccl->size	= n;
+	return	0;
+}
+
+/* Every parent has a lower index than its children */
+static
+int32_t	uf_find		(int32_t *uf, int32_t i)
+{
+
+	while (uf[i] != i) {
+		uf[i]	= uf[uf[i]];
+		i	= uf[i];
+	}
+	return	i;
+}
+
+static
+void	uf_union	(int32_t *uf, int32_t i, int32_t j)
+{
+
+	i	= uf_find(uf, i);
+	j	= uf_find(uf, j);
+	if (i < j)
+		uf[j]	= i;
+	else
+		uf[i]	= j;
+}
+
+static
+ptrdiff_t scan		(struct Ccl *restrict ccl, const uint8_t *restrict data,
+			 ptrdiff_t step)
+{
+	struct Ccl_Run	*runs, *r, *p;
+	const uint8_t	*row;
+	ptrdiff_t	n, prev, cur, j;
+	ptrdiff_t	x;
+	bool		fg;
+
+	n	= 0;
+	prev	= 0;
+	for (ptrdiff_t y = 0; y < ccl->h; y++) {
+		if (reserve(ccl, n + ccl->w))
+			return	-1;
+		runs	= ccl->runs;
+		row	= data + y * step;
+		cur	= n;
+		j	= prev;
+		for (x = 0; x < ccl->w;) {
+			r	= &runs[n];
+			fg	= row[x];
+			r->x0	= x;
+			while (x < ccl->w && !!row[x] == fg)
+				x++;
+			r->x1	= x;
+			r->y	= y;
+			r->fg	= fg;
+			ccl->uf[n]	= n;
+
+			/* 8-connected foreground, 4-connected background */
+			while (j < cur && runs[j].x1 + fg <= r->x0)
+				j++;
+			for (ptrdiff_t k = j; k < cur; k++) {
+				p	= &runs[k];
+				if (p->x0 >= r->x1 + fg)
+					break;
+				if (p->fg == fg)
+					uf_union(ccl->uf, k, n);
+			}
+			n++;
+		}
+		prev	= cur;
+	}
+	return	n;
+}
+
+static
+int	stats		(struct Ccl *ccl, ptrdiff_t nruns)
+{
+	struct Ccl_Run	*runs;
+	struct Ccl_Comp	*c;
+	int32_t		*uf;
+	ptrdiff_t	n;
+
+	runs	= ccl->runs;
+	uf	= ccl->uf;
+	/* uf[i] <= i:  in order, the parent of i is already a root */
+	n	= 0;
+	for (ptrdiff_t i = 0; i < nruns; i++) {
+		uf[i]	= uf[uf[i]];
+		runs[i].lbl	= (uf[i] == i) ? n++ : runs[uf[i]].lbl;
+	}
+
+	c	= reallocarray(ccl->comp, n, sizeof(*c));
+	if (!c)
+		return	-1;
+	ccl->comp	= c;
+	ccl->n		= n;
+
+	for (ptrdiff_t i = 0; i < nruns; i++) {
+		struct Ccl_Run	*r = &runs[i];
+		int32_t		*lbl = &ccl->lbl[r->y * ccl->w];
+
+		c	= &ccl->comp[r->lbl];
+		if (uf[i] == i) {
+			c->area		= 0;
+			c->perim	= 0;
+			c->x		= r->x0;
+			c->y		= r->y;
+			c->w		= r->x1 - r->x0;
+			c->h		= 1;
+			c->fg		= r->fg;
+			c->border	= false;
+			c->parent	= r->y ? lbl[r->x0 - ccl->w] : -1;
+		}
+		c->area	+= r->x1 - r->x0;
+		c->w	= MAX(c->x + c->w, r->x1) - MIN(c->x, r->x0);
+		c->x	= MIN(c->x, r->x0);
+		c->h	= r->y - c->y + 1;
+		if (!r->y || r->y == ccl->h - 1 || !r->x0 || r->x1 == ccl->w)
+			c->border	= true;
+		for (ptrdiff_t x = r->x0; x < r->x1; x++)
+			lbl[x]	= r->lbl;
+	}
+
+	/* Background touching the border is outside everything */
+	for (ptrdiff_t i = 0; i < n; i++) {
+		c	= &ccl->comp[i];
+		if (!c->fg && c->border)
+			c->parent	= -1;
+		c->area_f	= c->area;
+	}
+	for (ptrdiff_t i = n - 1; i >= 0; i--) {
+		c	= &ccl->comp[i];
+		if (c->parent >= 0)
+			ccl->comp[c->parent].area_f += c->area_f;
+	}
+	return	0;
+}
+
+/*
+ * A pixel is on the outer boundary of its component if a 4-neighbour is out
+ * of the image, or in the background but not in one of its holes.
+ */
+static
+void	perimeters	(struct Ccl *ccl, ptrdiff_t nruns)
+{
+	const struct Ccl_Run	*runs;
+	const int32_t		*lbl;
+	ptrdiff_t		w, h;
+	ptrdiff_t		nb[4];
+	int32_t			l;
+
+	runs	= ccl->runs;
+	w	= ccl->w;
+	h	= ccl->h;
+	for (ptrdiff_t i = 0; i < nruns; i++) {
+		if (!runs[i].fg)
+			continue;
+		l	= runs[i].lbl;
+		lbl	= &ccl->lbl[runs[i].y * w];
+		for (ptrdiff_t x = runs[i].x0; x < runs[i].x1; x++) {
+			if (!x || x == w - 1 || !runs[i].y || runs[i].y == h - 1) {
+				ccl->comp[l].perim++;
+				continue;
+			}
+			nb[0]	= lbl[x - 1];
+			nb[1]	= lbl[x + 1];
+			nb[2]	= lbl[x - w];
+			nb[3]	= lbl[x + w];
+			for (int k = 0; k < 4; k++) {
+				if (nb[k] != l && ccl->comp[nb[k]].parent != l) {
+					ccl->comp[l].perim++;
+					break;
+				}
+			}
+		}
+	}
+}
+
+static
+int	img_data	(const img_s *restrict img, uint8_t **restrict data,
+			 ptrdiff_t *restrict w, ptrdiff_t *restrict h,
+			 ptrdiff_t *restrict step)
+{
+	void		*d;
+	ptrdiff_t	B_per_pix;
+
+	alx_cv_extract_imgdata(img, &d, w, h, &B_per_pix, step, NULL);
+	if (B_per_pix != 1 || !*w || !*h)
+		return	-1;
+	if (*w > INT32_MAX || *w * *h > INT32_MAX)
+		return	-1;
+	*data	= d;
+	return	0;
+}
+
+static
+int	holes		(img_s *img, int op)
+{
+	struct Ccl	*ccl;
+	bool		*on;
+	int		status;
+
+	status	= -1;
+	if (pool_get_ccl(&ccl))
+		return	status;
+	if (ccl_label(ccl, img))
+		goto err0;
+	on	= pool_get_buf(sizeof(*on) * ccl->n);
+	if (!on)
+		goto err0;
+
+	for (ptrdiff_t i = 0; i < ccl->n; i++) {
+		switch (op) {
+		case CCL_HOLES_FILL:
+			on[i]	= ccl->comp[i].fg || !ccl->comp[i].border;
+			break;
+		case CCL_HOLES_REMOVE:
+			on[i]	= ccl_is_outer(ccl, i);
+			break;
+		case CCL_HOLES_EXTRACT:
+			on[i]	= ccl->comp[i].fg && !ccl_is_outer(ccl, i);
+			break;
+		}
+	}
+	status	= ccl_select(img, ccl, on);
+
+	pool_put_buf(on);
+err0:	pool_put_ccl(ccl);
+	return	status;
+}
+
+static
+int	cmp_x		(const void *a, const void *b, void *ccl)
+{
+	const struct Ccl	*c;
+	ptrdiff_t		xa, xb;
+
+	c	= ccl;
+	xa	= c->comp[*(const ptrdiff_t *)a].x;
+	xb	= c->comp[*(const ptrdiff_t *)b].x;
+	return	(xa > xb) - (xa < xb);
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
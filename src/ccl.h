@@ -0,0 +1,110 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* ccl.h */
+
+
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * Connected-component labeling of binary masks (8-bit, nonzero is
+ * foreground), in a single scan of runs with union-find.  Foreground is
+ * 8-connected and background 4-connected, and both are labeled at once, so
+ * that every component knows the one that encloses it:  holes are the
+ * background components that don't touch the border.
+ *
+ * It replaces the contours where only the blobs are needed (their size,
+ * bounding box, or count);  contours are still traced where a polygon is
+ * needed (e.g., alx_cv_min_area_rect()).
+ */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libalx/extra/cv/cv.h>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+struct	Ccl_Comp {
+	ptrdiff_t	area;	/* pixels */
+	ptrdiff_t	area_f;	/* pixels, with everything it encloses */
+	ptrdiff_t	perim;	/* pixels on its outer boundary */
+	ptrdiff_t	x, y, w, h;	/* bounding box */
+	ptrdiff_t	parent;	/* enclosing component, or -1 */
+	bool		fg;
+	bool		border;	/* touches the border of the image */
+};
+
+/* Components are numbered in raster order, so parents come first */
+struct	Ccl {
+	ptrdiff_t	w;
+	ptrdiff_t	h;
+	int32_t		*lbl;	/* component of every pixel */
+	ptrdiff_t	n;
+	struct Ccl_Comp	*comp;
+	/* internal buffers */
+	void		*runs;
+	int32_t		*uf;
+	ptrdiff_t	size;
+	ptrdiff_t	lbl_size;
+};
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+int	init_ccl	(struct Ccl **ccl);
+void	deinit_ccl	(struct Ccl *ccl);
+int	ccl_label	(struct Ccl *restrict ccl, const img_s *restrict img);
+
+bool	ccl_is_outer	(const struct Ccl *ccl, ptrdiff_t i);
+ptrdiff_t ccl_outer	(const struct Ccl *restrict ccl,
+			 ptrdiff_t *restrict idx, ptrdiff_t size);
+ptrdiff_t ccl_largest_a	(const struct Ccl *ccl);
+ptrdiff_t ccl_largest_p	(const struct Ccl *ccl);
+ptrdiff_t ccl_closest	(const struct Ccl *ccl, ptrdiff_t x, ptrdiff_t y);
+ptrdiff_t ccl_outer_of	(const struct Ccl *ccl, ptrdiff_t i);
+int	ccl_bounding_rect(rect_s *restrict rect,
+			 const struct Ccl *restrict ccl, ptrdiff_t i);
+int	ccl_mask	(img_s *restrict img,
+			 const struct Ccl *restrict ccl, ptrdiff_t i);
+int	ccl_select	(img_s *restrict img, const struct Ccl *restrict ccl,
+			 const bool *restrict on);
+
+void	ccl_holes_fill	(img_s *img);
+void	ccl_holes_remove(img_s *img);
+void	ccl_holes_extract(img_s *img);
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,120 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "ctx.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "cache.h"
+#include "ccl.h"
+#include "pool.h"
+#include "prof.h"
+#include "tasks.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+int	init_ctx	(struct Ctx **ctx, const struct Templates *t)
+{
+	struct Ctx	*c;
+	ptrdiff_t	i;
+
+	c	= malloc(sizeof(*c));
+	if (!c)
+		return	-1;
+	c->t	= t;
+	c->buf	= NULL;
+	c->size	= 0;
+	c->scale	= 1;
+	c->crop		= false;
+	c->nsyms	= 0;
+	c->prof		= NULL;
+	c->tasks	= NULL;
+	c->cache	= NULL;
+	if (alx_cv_init_img(&c->lbl))
+		goto err0;
+	if (alx_cv_init_img(&c->img))
+		goto err1;
+	for (i = 0; i < ARRAY_SSIZE(c->sym); i++) {
+		if (alx_cv_init_img(&c->sym[i]))
+			goto err2;
+		if (alx_cv_init_img(&c->part[i].base))
+			goto err3;
+		if (alx_cv_init_img(&c->part[i].inner))
+			goto err4;
+		if (init_ccl(&c->part[i].ccl))
+			goto err5;
+	}
+	if (init_pool(&c->pool))
+		goto err2;
+
+	*ctx	= c;
+	return	0;
+
+err2:	for (i--; i >= 0; i--) {
+		deinit_ccl(c->part[i].ccl);
+err5:		alx_cv_deinit_img(c->part[i].inner);
+err4:		alx_cv_deinit_img(c->part[i].base);
+err3:		alx_cv_deinit_img(c->sym[i]);
+	}
+	alx_cv_deinit_img(c->img);
+err1:	alx_cv_deinit_img(c->lbl);
+err0:	free(c);
+	return	-1;
+}
+
+void	deinit_ctx	(struct Ctx *ctx)
+{
+
+	deinit_cache(ctx->cache);
+	deinit_tasks(ctx->tasks);
+	deinit_prof(ctx->prof);
+	deinit_pool(ctx->pool);
+	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(ctx->sym); i++) {
+		deinit_ccl(ctx->part[i].ccl);
+		alx_cv_deinit_img(ctx->part[i].inner);
+		alx_cv_deinit_img(ctx->part[i].base);
+		alx_cv_deinit_img(ctx->sym[i]);
+	}
+	alx_cv_deinit_img(ctx->img);
+	alx_cv_deinit_img(ctx->lbl);
+	free(ctx);
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
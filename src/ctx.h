@@ -0,0 +1,98 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* ctx.h */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <libalx/extra/cv/cv.h>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+#define MAX_SYMBOLS	(5)
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+struct	Cache;
+struct	Ccl;
+struct	Pool;
+struct	Prof;
+struct	Tasks;
+struct	Templates;
+
+/* The parts of a symbol that the templates are matched against */
+struct	Sym_Parts {
+	struct Ccl	*ccl;		/* labeling of the symbol */
+	ptrdiff_t	base_comp;	/* component of the base, or -1 */
+	img_s		*base;
+	img_s		*inner;		/* what is inside the base */
+	bool		has_inner;
+	ptrdiff_t	lines;		/* below and around the base */
+};
+
+/*
+ * Everything that belongs to one image in flight.  The templates are shared
+ * (read only) by all the contexts; anything else is owned by the context, so
+ * that different contexts can be used concurrently.
+ */
+struct	Ctx {
+	const struct Templates	*t;
+	/* The encoded image being read */
+	const void		*buf;
+	size_t			size;
+	/* The image, reduced by 1/scale, to find the label */
+	img_s			*lbl;
+	int			scale;
+	/* JPEG:  img isn't decoded until the label is found, and only that */
+	bool			crop;
+	img_s			*img;
+	/* Views of img, until clean_symbol() gives them pixels of their own */
+	img_s			*sym[MAX_SYMBOLS];
+	struct Sym_Parts	part[MAX_SYMBOLS];
+	ptrdiff_t		nsyms;
+	/* Scratch objects of the stages (see pool.h) */
+	struct Pool		*pool;
+	/* NULL unless profiling (see init_prof()) */
+	struct Prof		*prof;
+	/* NULL unless the symbols are read in parallel (see init_tasks()) */
+	struct Tasks		*tasks;
+	/* NULL unless the results are cached (see init_cache()) */
+	struct Cache		*cache;
+};
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+int	init_ctx	(struct Ctx **ctx, const struct Templates *t);
+void	deinit_ctx	(struct Ctx *ctx);
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,173 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "cvx.h"
+
+#include <climits>
+#include <cstddef>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+int	cvx_decode	(img_s *img, const void *buf, size_t size)
+{
+
+	if (!size || size > INT_MAX)
+		return	-1;
+	try {
+		/* Wrap, don't copy, the encoded bytes */
+		const cv::Mat	enc(1, size, CV_8UC1, const_cast<void *>(buf));
+
+		*img	= cv::imdecode(enc, cv::IMREAD_COLOR);
+	} catch (...) {
+		return	-1;
+	}
+	if (img->empty())
+		return	-1;
+	return	0;
+}
+
+int	cvx_wrap_gray	(img_s *img, const void *data,
+			 ptrdiff_t w, ptrdiff_t h, ptrdiff_t step)
+{
+
+	try {
+		/* The data is never written through img */
+		*img	= cv::Mat(h, w, CV_8UC1, const_cast<void *>(data),
+								step);
+	} catch (...) {
+		return	-1;
+	}
+	return	0;
+}
+
+
+int	cvx_create_bgr	(img_s *img, ptrdiff_t w, ptrdiff_t h)
+{
+
+	try {
+		img->create(h, w, CV_8UC3);
+	} catch (...) {
+		return	-1;
+	}
+	return	0;
+}
+
+int	cvx_roi_clamp	(img_s *img,
+			 ptrdiff_t *x, ptrdiff_t *y,
+			 ptrdiff_t *w, ptrdiff_t *h)
+{
+	cv::Rect	r;
+
+	r	= cv::Rect(*x, *y, *w, *h) & cv::Rect(0, 0, img->cols, img->rows);
+	if (r.width <= 0 || r.height <= 0)
+		return	-1;
+	try {
+		*img	= (*img)(r);
+	} catch (...) {
+		return	-1;
+	}
+	*x	= r.x;
+	*y	= r.y;
+	*w	= r.width;
+	*h	= r.height;
+	return	0;
+}
+
+void	cvx_view	(img_s *dst, const img_s *src)
+{
+
+	*dst	= *src;
+}
+
+int	cvx_unshare	(img_s *img)
+{
+
+	/* Not allocated by OpenCV (see cvx_wrap_gray()), or not alone */
+	if (img->u && img->u->refcount == 1)
+		return	0;
+	try {
+		*img	= img->clone();
+	} catch (...) {
+		/* Don't leave a view to be written by mistake */
+		img->release();
+		return	-1;
+	}
+	return	0;
+}
+
+int	cvx_downscale	(img_s *dst, const img_s *src, int scale)
+{
+
+	try {
+		cv::resize(*src, *dst, cv::Size(), 1.0 / scale, 1.0 / scale,
+							cv::INTER_AREA);
+	} catch (...) {
+		return	-1;
+	}
+	return	0;
+}
+
+void	cvx_extract_rect_rot(const rect_rot_s *rect_rot,
+			 double *x, double *y, double *w, double *h,
+			 double *angle)
+{
+
+	if (x)
+		*x	= rect_rot->center.x;
+	if (y)
+		*y	= rect_rot->center.y;
+	if (w)
+		*w	= rect_rot->size.width;
+	if (h)
+		*h	= rect_rot->size.height;
+	if (angle)
+		*angle	= rect_rot->angle;
+}
+
+void	cvx_set_rect_rot(rect_rot_s *rect_rot,
+			 double x, double y, double w, double h,
+			 double angle)
+{
+
+	rect_rot->center.x	= x;
+	rect_rot->center.y	= y;
+	rect_rot->size.width	= w;
+	rect_rot->size.height	= h;
+	rect_rot->angle		= angle;
+}
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
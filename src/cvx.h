@@ -0,0 +1,101 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* cvx.h */
+
+
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * Extensions to libalx-cv:  the few image operations that this program needs
+ * and libalx doesn't provide.  They are implemented in C++ directly on the
+ * cv::Mat behind every img_s.
+ */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <stddef.h>
+
+#if defined(__cplusplus)
+#include <opencv2/core.hpp>
+typedef	class cv::Mat		img_s;
+typedef	class cv::RotatedRect	rect_rot_s;
+#else
+#include <libalx/extra/cv/cv.h>
+#endif
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+#if defined(__cplusplus)
+extern	"C" {
+#endif
+
+/* Decode an encoded image (JPEG, PNG, ...) from memory, like alx_cv_imread() */
+int	cvx_decode	(img_s *img, const void *buf, size_t size);
+/* Make img an 8-bit gray image over data, without copying it */
+int	cvx_wrap_gray	(img_s *img, const void *data,
+			 ptrdiff_t w, ptrdiff_t h, ptrdiff_t step);
+/* (Re)allocate img as a w x h BGR image;  its contents are undefined */
+int	cvx_create_bgr	(img_s *img, ptrdiff_t w, ptrdiff_t h);
+/* Set the ROI of img to (*x, *y, *w, *h), clipped to the image */
+int	cvx_roi_clamp	(img_s *img,
+			 ptrdiff_t *x, ptrdiff_t *y,
+			 ptrdiff_t *w, ptrdiff_t *h);
+/*
+ * Make dst a view of src (of its ROI), sharing the pixels;  it must not be
+ * written until cvx_unshare() gives it pixels of its own.
+ */
+void	cvx_view	(img_s *dst, const img_s *src);
+/*
+ * Copy the pixels of img (only its ROI) if they are shared with any other
+ * image;  on error, img is left empty.
+ */
+int	cvx_unshare	(img_s *img);
+/* dst = src reduced by 1/scale (area interpolation) */
+int	cvx_downscale	(img_s *dst, const img_s *src, int scale);
+void	cvx_extract_rect_rot(const rect_rot_s *rect_rot,
+			 double *x, double *y, double *w, double *h,
+			 double *angle);
+void	cvx_set_rect_rot(rect_rot_s *rect_rot,
+			 double x, double y, double w, double h,
+			 double angle);
+
+#if defined(__cplusplus)
+}	/* extern "C" */
+#endif
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
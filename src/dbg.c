@@ -0,0 +1,265 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "dbg.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/base/stdio.h>
+#include <libalx/extra/cv/cv.h>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+/* Images waiting to be written;  any more are dropped, not waited for */
+#define DBG_QUEUE	(64)
+#define DBG_NAME_MAX	(32)
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+struct	Dbg_Item {
+	img_s	*img;
+	char	fname[FILENAME_MAX];
+};
+
+struct	Dbg_Writer {
+	pthread_t		thr;
+	pthread_mutex_t		mutex;
+	pthread_cond_t		cond;
+	struct Dbg_Item		q[DBG_QUEUE];
+	ptrdiff_t		head;
+	ptrdiff_t		n;
+	bool			quit;
+	ptrdiff_t		dropped;
+};
+
+
+/******************************************************************************
+ ******* variables ************************************************************
+ ******************************************************************************/
+int				dbg_level;
+const char			*dbg_dir;
+_Thread_local unsigned		dbg_req;
+
+static _Thread_local unsigned	seq;
+static unsigned			every;
+static atomic_uint		nreq;
+static struct Dbg_Writer	*writer;
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+void	*write_imgs	(void *arg);
+static
+void	push		(struct Dbg_Writer *restrict w,
+			 const img_s *restrict img,
+			 const char *restrict fname);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+/*
+ * Level 0 (or less) is off.  With a dir, the images are written to it
+ * instead of shown in a window, and only one request in every `sample` is
+ * debugged.
+ */
+int	init_dbg	(int level, const char *dir, int sample)
+{
+	struct Dbg_Writer	*w;
+
+	level	= MIN(level, 4);
+	if (level <= 0)
+		return	0;
+	every	= MAX(sample, 1);
+	atomic_init(&nreq, 0);
+
+	if (!dir) {
+		alx_cv_named_window("dbg", ALX_CV_WINDOW_NORMAL);
+		goto out;
+	}
+	if (mkdir(dir, 0777) && errno != EEXIST)
+		return	-1;
+	w	= calloc(1, sizeof(*w));
+	if (!w)
+		return	-1;
+	if (pthread_mutex_init(&w->mutex, NULL))
+		goto err0;
+	if (pthread_cond_init(&w->cond, NULL))
+		goto err1;
+	if (pthread_create(&w->thr, NULL, &write_imgs, w))
+		goto err2;
+	writer	= w;
+	dbg_dir	= dir;
+out:
+	dbg_level	= level;
+	return	0;
+
+err2:	pthread_cond_destroy(&w->cond);
+err1:	pthread_mutex_destroy(&w->mutex);
+err0:	free(w);
+	return	-1;
+}
+
+/* Write whatever is still queued */
+void	deinit_dbg	(void)
+{
+	struct Dbg_Writer	*w;
+
+	if (!dbg_level)
+		return;
+	dbg_level	= 0;
+	w	= writer;
+	if (!w) {
+		alx_cv_destroy_all_windows();
+		return;
+	}
+
+	pthread_mutex_lock(&w->mutex);
+	w->quit	= true;
+	pthread_cond_signal(&w->cond);
+	pthread_mutex_unlock(&w->mutex);
+	pthread_join(w->thr, NULL);
+	if (w->dropped)
+		fprintf(stderr, "[warning]	debug: %ti images dropped\n",
+								w->dropped);
+
+	pthread_cond_destroy(&w->cond);
+	pthread_mutex_destroy(&w->mutex);
+	free(w);
+	writer	= NULL;
+	dbg_dir	= NULL;
+}
+
+/* A request starts in this thread;  decide if it's debugged */
+void	dbg_begin	(void)
+{
+	unsigned	n;
+
+	if (!dbg_level)
+		return;
+	n	= atomic_fetch_add(&nreq, 1);
+	dbg_req	= n % every ? 0 : n + 1;
+	seq	= 0;
+}
+
+void	dbg_end		(void)
+{
+
+	dbg_req	= 0;
+}
+
+/*
+ * Show img, or queue a copy of it to be written as
+ * <dir>/<request>_<n>_<func>_<name>.png, where n counts the images of the
+ * request.
+ */
+void	dbg_img		(int dbg, const img_s *img,
+			 const char *func, const char *name)
+{
+	char		fname[FILENAME_MAX];
+	char		nm[DBG_NAME_MAX];
+	ptrdiff_t	i;
+
+	if (!writer) {
+		alx_cv_imshow(img, "dbg", DBG_SHOWTIME(dbg));
+		return;
+	}
+
+	for (i = 0; name[i] && i < ARRAY_SSIZE(nm) - 1; i++)
+		nm[i]	= isalnum((unsigned char)name[i]) ? name[i] : '_';
+	nm[i]	= '\0';
+	if (sbprintf(fname, NULL, "%s/%06u_%03u_%s_%s.png", dbg_dir,
+						dbg_req - 1, seq++, func, nm))
+		return;
+	push(writer, img, fname);
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+static
+void	*write_imgs	(void *arg)
+{
+	struct Dbg_Writer	*w;
+	struct Dbg_Item		it;
+
+	w	= arg;
+	pthread_mutex_lock(&w->mutex);
+	for (;;) {
+		while (!w->n && !w->quit)
+			pthread_cond_wait(&w->cond, &w->mutex);
+		if (!w->n)
+			break;
+		it	= w->q[w->head];
+		w->head	= (w->head + 1) % DBG_QUEUE;
+		w->n--;
+		pthread_mutex_unlock(&w->mutex);
+
+		if (alx_cv_imwrite(it.img, it.fname))
+			fprintf(stderr, "[warning]	debug: %s\n", it.fname);
+		alx_cv_deinit_img(it.img);
+
+		pthread_mutex_lock(&w->mutex);
+	}
+	pthread_mutex_unlock(&w->mutex);
+
+	return	NULL;
+}
+
+/* Never waits for the writer:  if the queue is full, img is dropped */
+static
+void	push		(struct Dbg_Writer *restrict w,
+			 const img_s *restrict img,
+			 const char *restrict fname)
+{
+	struct Dbg_Item	*it;
+	img_s		*cp;
+
+	if (alx_cv_init_img(&cp))
+		return;
+	alx_cv_clone(cp, img);
+
+	pthread_mutex_lock(&w->mutex);
+	if (w->n == DBG_QUEUE) {
+		w->dropped++;
+		pthread_mutex_unlock(&w->mutex);
+		alx_cv_deinit_img(cp);
+		return;
+	}
+	it	= &w->q[(w->head + w->n) % DBG_QUEUE];
+	it->img	= cp;
+	snprintf(it->fname, sizeof(it->fname), "%s", fname);
+	w->n++;
+	pthread_cond_signal(&w->cond);
+	pthread_mutex_unlock(&w->mutex);
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -10,10 +10,23 @@
 #pragma once	/* dbg.h */
 
 
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * Debugging is off unless init_dbg() is called with a level (1 to 4;  the
+ * higher, the more is shown).  Then every request (see dbg_begin()), or
+ * one in every `sample`, shows the images of its stages up to that level:
+ * in a window, or, if there is a directory, as PNGs written to it by a
+ * background thread (see dbg_img()).  Off, the macros below cost a branch.
+ */
+
+
 /******************************************************************************
  ******* headers **************************************************************
  ******************************************************************************/
 #include <stdbool.h>
+#include <stdio.h>
 
 #define ALX_NO_PREFIX
 #include <libalx/base/errno.h>
@@ -24,7 +37,8 @@
 /******************************************************************************
  ******* macro ****************************************************************
  ******************************************************************************/
-#define DBG			0
+/* Debug level of the request in this thread (0 if it isn't sampled) */
+#define DBG			(dbg_level && dbg_req ? dbg_level : 0)
 #define DBG_SHOW_WAIT		0
 #define DBG_SHOWTIME(dbg)	(					\
 {									\
@@ -55,12 +69,11 @@
 }									\
 )
 
-#if defined(DBG)
 #define dbg_show(dbg, img)		do				\
 {									\
 									\
 	if (dbg <= DBG) {						\
-		alx_cv_imshow(img, "dbg", DBG_SHOWTIME(dbg));		\
+		dbg_img(dbg, img, __func__, #img);			\
 	}								\
 } while (0);
 
@@ -68,22 +81,18 @@
 {									\
 									\
 	if (dbg <= DBG) {						\
-		printf(fmt, ##__VA_ARGS__);				\
+		fprintf(stderr, fmt, ##__VA_ARGS__);			\
 	}								\
 } while (0);
 
 #define dbg_update_win()		do				\
 {									\
 									\
-	if (DBG) {							\
+	if (DBG && !dbg_dir) {						\
 		alx_cv_destroy_all_windows();				\
 		alx_cv_named_window("dbg", ALX_CV_WINDOW_NORMAL);	\
 	}								\
 } while (0);
-#else
-#define dbg_show(dbg, img)	do {} while (0);
-#define dbg_update_win()	do {} while (0);
-#endif	/* defined(DBG) */
 
 
 /******************************************************************************
@@ -96,9 +105,23 @@
  ******************************************************************************/
 
 
+/******************************************************************************
+ ******* variables ************************************************************
+ ******************************************************************************/
+extern	int				dbg_level;
+extern	const char			*dbg_dir;
+extern	_Thread_local unsigned		dbg_req;
+
+
 /******************************************************************************
  ******* prototypes ***********************************************************
  ******************************************************************************/
+int	init_dbg	(int level, const char *dir, int sample);
+void	deinit_dbg	(void);
+void	dbg_begin	(void);
+void	dbg_end		(void);
+void	dbg_img		(int dbg, const img_s *img,
+			 const char *func, const char *name);
 
 
 /******************************************************************************
@@ -0,0 +1,123 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "hash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+#define HASH_C1		UINT64_C(0x87C37B91114253D5)
+#define HASH_C2		UINT64_C(0x4CF5AD432745937F)
+
+#define rotl64(x, r)	(((x) << (r)) | ((x) >> (64 - (r))))
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+uint64_t	fmix64		(uint64_t k);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+/* 16 bytes at a time, at a few GB/s */
+void	hash128		(uint64_t h[2], const void *buf, size_t size)
+{
+	const unsigned char	*p;
+	uint64_t		h1, h2, k1, k2;
+	size_t			n;
+
+	p	= buf;
+	h1	= 0;
+	h2	= 0;
+	for (n = size / 16; n; n--, p += 16) {
+		memcpy(&k1, p, sizeof(k1));
+		memcpy(&k2, p + 8, sizeof(k2));
+
+		k1	*= HASH_C1;
+		k1	= rotl64(k1, 31);
+		k1	*= HASH_C2;
+		h1	^= k1;
+		h1	= rotl64(h1, 27);
+		h1	+= h2;
+		h1	= h1 * 5 + 0x52DCE729;
+
+		k2	*= HASH_C2;
+		k2	= rotl64(k2, 33);
+		k2	*= HASH_C1;
+		h2	^= k2;
+		h2	= rotl64(h2, 31);
+		h2	+= h1;
+		h2	= h2 * 5 + 0x38495AB5;
+	}
+
+	/* The last 0 to 15 bytes, little endian */
+	k1	= 0;
+	k2	= 0;
+	for (n = size % 16; n > 8; n--)
+		k2	= k2 << 8 | p[n - 1];
+	for (; n; n--)
+		k1	= k1 << 8 | p[n - 1];
+	if (size % 16 > 8) {
+		k2	*= HASH_C2;
+		k2	= rotl64(k2, 33);
+		k2	*= HASH_C1;
+		h2	^= k2;
+	}
+	if (size % 16) {
+		k1	*= HASH_C1;
+		k1	= rotl64(k1, 31);
+		k1	*= HASH_C2;
+		h1	^= k1;
+	}
+
+	h1	^= size;
+	h2	^= size;
+	h1	+= h2;
+	h2	+= h1;
+	h1	= fmix64(h1);
+	h2	= fmix64(h2);
+	h1	+= h2;
+	h2	+= h1;
+	h[0]	= h1;
+	h[1]	= h2;
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+static
+uint64_t	fmix64		(uint64_t k)
+{
+
+	k	^= k >> 33;
+	k	*= UINT64_C(0xFF51AFD7ED558CCD);
+	k	^= k >> 33;
+	k	*= UINT64_C(0xC4CEB9FE1A85EC53);
+	k	^= k >> 33;
+	return	k;
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
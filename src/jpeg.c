@@ -0,0 +1,276 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "jpeg.h"
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <sys/param.h>
+
+#include <jpeglib.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "cvx.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+#define EXIF_MARKER		(JPEG_APP0 + 1)
+#define EXIF_TAG_ORIENTATION	(0x0112)
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+/* libjpeg calls exit() on errors, unless error_exit() doesn't return */
+struct	Jpeg_Err {
+	struct jpeg_error_mgr	mgr;
+	jmp_buf			env;
+};
+
+struct	Jpeg {
+	struct jpeg_decompress_struct	cinfo;
+	struct Jpeg_Err			err;
+};
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+void	jpeg_err_exit	(j_common_ptr cinfo);
+static
+int	read_lines	(struct Jpeg *restrict j, img_s *restrict img,
+			 ptrdiff_t h);
+static
+int	exif_orientation(const struct jpeg_decompress_struct *cinfo);
+static
+uint32_t exif_read	(const unsigned char *p, int nbytes, bool le);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+/*
+ * Smallest scale (1, 1/2, 1/4 or 1/8) at which the shorter side of a w x h
+ * image still has at least min_px pixels;  returns the denominator.
+ */
+int	jpeg_scale		(ptrdiff_t w, ptrdiff_t h, ptrdiff_t min_px)
+{
+	int	scale;
+
+	scale	= 1;
+	while (scale < JPEG_SCALE_MAX && MIN(w, h) / (scale * 2) >= min_px)
+		scale	*= 2;
+	return	scale;
+}
+
+bool	is_jpeg			(const void *buf, size_t size)
+{
+	const unsigned char	*p;
+
+	p	= buf;
+	return	size > 3 && p[0] == 0xFF && p[1] == 0xD8 && p[2] == 0xFF;
+}
+
+/*
+ * Decode at jpeg_scale(), which is returned in *scale.  Fails for images
+ * that aren't upright (EXIF Orientation other than 1), which have to be
+ * decoded by cvx_decode().
+ */
+int	decode_jpeg_scaled	(img_s *restrict img,
+				 const void *restrict buf, size_t size,
+				 ptrdiff_t min_px, int *restrict scale)
+{
+	struct Jpeg	j;
+	int		status;
+
+	j.cinfo.err	= jpeg_std_error(&j.err.mgr);
+	j.err.mgr.error_exit	= &jpeg_err_exit;
+	if (setjmp(j.err.env)) {
+		jpeg_destroy_decompress(&j.cinfo);
+		return	-1;
+	}
+	jpeg_create_decompress(&j.cinfo);
+	jpeg_mem_src(&j.cinfo, buf, size);
+	jpeg_save_markers(&j.cinfo, EXIF_MARKER, 0xFFFF);
+	jpeg_read_header(&j.cinfo, true);
+	status	= -1;
+	if (exif_orientation(&j.cinfo) != 1)
+		goto err;
+
+	*scale	= jpeg_scale(j.cinfo.image_width, j.cinfo.image_height,
+								min_px);
+	j.cinfo.scale_num	= 1;
+	j.cinfo.scale_denom	= *scale;
+	j.cinfo.out_color_space	= JCS_EXT_BGR;
+	jpeg_start_decompress(&j.cinfo);
+
+	if (cvx_create_bgr(img, j.cinfo.output_width, j.cinfo.output_height))
+		goto err;
+	if (read_lines(&j, img, j.cinfo.output_height))
+		goto err;
+	jpeg_finish_decompress(&j.cinfo);
+
+	status	= 0;
+err:	jpeg_destroy_decompress(&j.cinfo);
+	return	status;
+}
+
+/*
+ * Decode only the region (*x, *y, *w, *h) at full resolution.  libjpeg can
+ * only start a line at an iMCU boundary, so the region is widened to the
+ * left;  the region actually decoded is returned through the pointers.
+ * Only for images that decode_jpeg_scaled() accepted (upright), so that
+ * the region is the same one.
+ */
+int	decode_jpeg_crop	(img_s *restrict img,
+				 const void *restrict buf, size_t size,
+				 ptrdiff_t *restrict x, ptrdiff_t *restrict y,
+				 ptrdiff_t *restrict w, ptrdiff_t *restrict h)
+{
+	struct Jpeg	j;
+	JDIMENSION	xoff, width;
+	int		status;
+
+	j.cinfo.err	= jpeg_std_error(&j.err.mgr);
+	j.err.mgr.error_exit	= &jpeg_err_exit;
+	if (setjmp(j.err.env)) {
+		jpeg_destroy_decompress(&j.cinfo);
+		return	-1;
+	}
+	jpeg_create_decompress(&j.cinfo);
+	jpeg_mem_src(&j.cinfo, buf, size);
+	jpeg_read_header(&j.cinfo, true);
+	j.cinfo.out_color_space	= JCS_EXT_BGR;
+	jpeg_start_decompress(&j.cinfo);
+
+	status	= -1;
+	*x	= MAX(*x, 0);
+	*y	= MAX(*y, 0);
+	*w	= MIN(*w, (ptrdiff_t)j.cinfo.output_width - *x);
+	*h	= MIN(*h, (ptrdiff_t)j.cinfo.output_height - *y);
+	if (*w <= 0 || *h <= 0)
+		goto err;
+	xoff	= *x;
+	width	= *w;
+	jpeg_crop_scanline(&j.cinfo, &xoff, &width);
+	*x	= xoff;
+	*w	= width;
+	if (jpeg_skip_scanlines(&j.cinfo, *y) != (JDIMENSION)*y)
+		goto err;
+
+	status--;
+	if (cvx_create_bgr(img, *w, *h))
+		goto err;
+	if (read_lines(&j, img, *h))
+		goto err;
+	/* The rest of the image is never decoded */
+	jpeg_abort_decompress(&j.cinfo);
+
+	status	= 0;
+err:	jpeg_destroy_decompress(&j.cinfo);
+	return	status;
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+static
+void	jpeg_err_exit	(j_common_ptr cinfo)
+{
+	struct Jpeg_Err	*err;
+
+	err	= (struct Jpeg_Err *)cinfo->err;
+	longjmp(err->env, 1);
+}
+
+static
+int	read_lines	(struct Jpeg *restrict j, img_s *restrict img,
+			 ptrdiff_t h)
+{
+	unsigned char	*data;
+	JSAMPROW	row;
+	ptrdiff_t	B_per_line;
+
+	alx_cv_extract_imgdata(img, (void **)&data, NULL, NULL, NULL,
+							&B_per_line, NULL);
+	for (ptrdiff_t i = 0; i < h; i++) {
+		row	= data + i * B_per_line;
+		if (jpeg_read_scanlines(&j->cinfo, &row, 1) != 1)
+			return	-1;
+	}
+	return	0;
+}
+
+/* The Orientation tag of the EXIF (APP1) IFD0, or 1 if there's none */
+static
+int	exif_orientation(const struct jpeg_decompress_struct *cinfo)
+{
+	const unsigned char	*p;
+	size_t			len, ifd, e;
+	ptrdiff_t		n;
+	bool			le;
+
+	for (jpeg_saved_marker_ptr m = cinfo->marker_list; m; m = m->next) {
+		if (m->marker != EXIF_MARKER || m->data_length < 6 + 8)
+			continue;
+		if (memcmp(m->data, "Exif\0\0", 6))
+			continue;
+		/* A TIFF header, and offsets from it */
+		p	= m->data + 6;
+		len	= m->data_length - 6;
+		if (!memcmp(p, "II*\0", 4))
+			le	= true;
+		else if (!memcmp(p, "MM\0*", 4))
+			le	= false;
+		else
+			return	1;
+		ifd	= exif_read(p + 4, 4, le);
+		if (ifd > len - 2)
+			return	1;
+		n	= exif_read(p + ifd, 2, le);
+		for (ptrdiff_t i = 0; i < n; i++) {
+			e	= ifd + 2 + 12 * i;
+			if (e + 12 > len)
+				return	1;
+			if (exif_read(p + e, 2, le) == EXIF_TAG_ORIENTATION)
+				return	exif_read(p + e + 8, 2, le);
+		}
+		return	1;
+	}
+	return	1;
+}
+
+/* An unsigned integer of nbytes, little or big endian */
+static
+uint32_t exif_read	(const unsigned char *p, int nbytes, bool le)
+{
+	uint32_t	x;
+
+	x	= 0;
+	for (int i = 0; i < nbytes; i++)
+		x	= x << 8 | p[le ? nbytes - 1 - i : i];
+	return	x;
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,73 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* jpeg.h */
+
+
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * JPEG decoding through libjpeg(-turbo), for what OpenCV can't do:  decoding
+ * at 1/2, 1/4 or 1/8 of the resolution in the DCT domain, and decoding only a
+ * region of the image.  Images are BGR, like the ones from alx_cv_imread().
+ *
+ * OpenCV also rotates (or flips) images as their EXIF Orientation says;
+ * those are refused here, to be decoded by OpenCV.
+ */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <libalx/extra/cv/cv.h>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+/* Largest reduction that libjpeg does in the DCT domain */
+#define JPEG_SCALE_MAX	(8)
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+int	jpeg_scale		(ptrdiff_t w, ptrdiff_t h, ptrdiff_t min_px);
+bool	is_jpeg			(const void *buf, size_t size);
+int	decode_jpeg_scaled	(img_s *restrict img,
+				 const void *restrict buf, size_t size,
+				 ptrdiff_t min_px, int *restrict scale);
+int	decode_jpeg_crop	(img_s *restrict img,
+				 const void *restrict buf, size_t size,
+				 ptrdiff_t *restrict x, ptrdiff_t *restrict y,
+				 ptrdiff_t *restrict w, ptrdiff_t *restrict h);
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
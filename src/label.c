@@ -9,6 +9,7 @@
  ******************************************************************************/
 #include "label.h"
 
+#include <math.h>
 #include <stddef.h>
 
 #include <sys/param.h>
@@ -20,7 +21,14 @@
 #include <libalx/base/stdlib.h>
 #include <libalx/extra/cv/cv.h>
 
+#include "ccl.h"
+#include "ctx.h"
+#include "cvx.h"
 #include "dbg.h"
+#include "jpeg.h"
+#include "median.h"
+#include "morph.h"
+#include "pool.h"
 
 
 /******************************************************************************
@@ -36,42 +44,64 @@
 /******************************************************************************
  ******* static prototypes ****************************************************
  ******************************************************************************/
+static
+int	pyr_scale			(ptrdiff_t w, ptrdiff_t h,
+					 ptrdiff_t min_px);
+static
+int	refine_band			(const img_s *restrict img,
+					 img_s *restrict tmp,
+					 struct Ccl *restrict ccl,
+					 rect_s *restrict rect,
+					 ptrdiff_t *restrict y,
+					 ptrdiff_t *restrict h, int s);
+static
+int	crop_label			(struct Ctx *restrict ctx,
+					 rect_rot_s *restrict rect_rot);
 
 
 /******************************************************************************
  ******* global functions *****************************************************
  ******************************************************************************/
-int	find_label			(img_s *img)
+int	find_label			(struct Ctx *ctx)
 {
+	img_s		*img;
 	img_s		*tmp;
 	conts_s		*conts;
 	const cont_s	*lbl;
 	rect_rot_s	*rect_rot;
 	rect_s		*rect;
+	int		s;
 	int		status;
 
 	/* init */
+	img	= ctx->img;
+	s	= ctx->scale;
 	status	= -1;
-	if (alx_cv_init_img(&tmp))
+	if (pool_get_img(&tmp))
 		return	status;
-	if (alx_cv_init_conts(&conts))
+	if (pool_get_conts(&conts))
 		goto err0;
-	if (alx_cv_init_rect_rot(&rect_rot))
+	if (pool_get_rect_rot(&rect_rot))
 		goto err1;
-	if (alx_cv_init_rect(&rect))
+	if (pool_get_rect(&rect))
 		goto err2;
 
-	/* Find label */
+	/* Find label (in the reduced image) */
 	status--;
-	alx_cv_clone(tmp, img);					dbg_show(2, tmp);
+	alx_cv_clone(tmp, ctx->lbl);				dbg_show(2, tmp);
 	alx_cv_white_mask(tmp, 50, 50, 45);			dbg_show(3, tmp);
-	alx_cv_dilate_erode(tmp, 10);				dbg_show(3, tmp);
-	alx_cv_erode_dilate(tmp, 30);				dbg_show(3, tmp);
+	morph_dilate_erode(tmp, MAX(10 / s, 1));		dbg_show(3, tmp);
+	morph_erode_dilate(tmp, MAX(30 / s, 1));		dbg_show(3, tmp);
 	alx_cv_contours(tmp, conts);
 	if (alx_cv_conts_largest_a(&lbl, NULL, conts))
 		goto err;
 	alx_cv_min_area_rect(rect_rot, lbl);
 
+	/* Decode (or crop) the label at full resolution */
+	status--;
+	if (crop_label(ctx, rect_rot))
+		goto err;				dbg_show(3, img);
+
 	/* Align & crop to label */
 	status--;
 	alx_cv_rotate_2rect(img, rect_rot, rect);		dbg_show(3, img);
@@ -79,129 +109,172 @@ int	find_label			(img_s *img)
 
 	/* deinit */
 	status	= 0;
-err:	alx_cv_deinit_rect(rect);
-err2:	alx_cv_deinit_rect_rot(rect_rot);
-err1:	alx_cv_deinit_conts(conts);
-err0:	alx_cv_deinit_img(tmp);
+err:	pool_put_rect(rect);
+err2:	pool_put_rect_rot(rect_rot);
+err1:	pool_put_conts(conts);
+err0:	pool_put_img(tmp);
 	return	status;
 }
 
-int	find_symbols_vertically		(img_s *img)
+/*
+ * The band of symbols is found in a reduced copy of the label (a level of a
+ * pyramid, down to about SYMS_MIN_PX pixels), its edges are found again at
+ * full resolution in the few rows around it, and the label is then cropped
+ * to it.
+ */
+int	find_symbols_vertically		(struct Ctx *ctx)
 {
-	img_s		*clean, *tmp, *bkgd;
-	conts_s		*conts;
-	const cont_s	*syms;
+	img_s		*img;
+	img_s		*lvl;
+	img_s		*tmp, *bkgd;
+	struct Ccl	*ccl;
 	rect_s		*rect;
 	ptrdiff_t	x, y, w, h;
+	ptrdiff_t	by, bh;
+	ptrdiff_t	syms;
+	int		s;
 	int		status;
 
 	/* init */
+	img	= ctx->img;
 	status	= -1;
-	if (alx_cv_init_img(&clean))
+	if (pool_get_img(&bkgd))
 		return	status;
-	if (alx_cv_init_img(&bkgd))
+	if (pool_get_img(&tmp))
 		goto err0;
-	if (alx_cv_init_img(&tmp))
+	if (pool_get_ccl(&ccl))
 		goto err1;
-	if (alx_cv_init_conts(&conts))
+	if (pool_get_rect(&rect))
 		goto err2;
-	if (alx_cv_init_rect(&rect))
+	if (pool_get_img(&lvl))
 		goto err3;
 
-	/* Clean BKGD */
+	/* Pyramid level */
 	status--;
-	alx_cv_clone(tmp, img);					dbg_show(2, tmp);
-	alx_cv_component(img, ALX_CV_CMP_BGR_R);		dbg_show(3, img);
-	alx_cv_smooth(img, ALX_CV_SMOOTH_MEDIAN, 3);		dbg_show(3, img);
-	alx_cv_clone(bkgd, img);				dbg_show(2, bkgd);
-	alx_cv_clone(clean, img);				dbg_show(3, clean);
+	alx_cv_extract_imgdata(img, NULL, &w, &h, NULL, NULL, NULL);
+	s	= pyr_scale(w, h, SYMS_MIN_PX);
+	if (cvx_downscale(lvl, img, s))
+		goto err;
+
+	/* Clean BKGD (lvl is cleaned in place) */
+	status--;
+	alx_cv_clone(tmp, lvl);					dbg_show(2, tmp);
+	alx_cv_component(lvl, ALX_CV_CMP_BGR_R);		dbg_show(3, lvl);
+	median_blur(lvl, MEDIAN_NET, 3);			dbg_show(3, lvl);
+	alx_cv_clone(bkgd, lvl);				dbg_show(2, bkgd);
 	alx_cv_white_mask(tmp, -1, 32, 64);			dbg_show(3, tmp);
-	alx_cv_dilate_erode(tmp, 5);				dbg_show(3, tmp);
+	morph_dilate_erode(tmp, MAX(5 / s, 1));			dbg_show(3, tmp);
 	alx_cv_bkgd_mask(tmp);					dbg_show(3, tmp);
-	alx_cv_dilate(tmp, 10);					dbg_show(3, tmp);
+	morph_dilate(tmp, MAX(10 / s, 1));			dbg_show(3, tmp);
 	alx_cv_median(bkgd);					dbg_show(3, bkgd);
 	alx_cv_and_2ref(bkgd, tmp);				dbg_show(3, bkgd);
 	alx_cv_invert(tmp);					dbg_show(3, tmp);
-	alx_cv_and_2ref(clean, tmp);				dbg_show(3, clean);
-	alx_cv_or_2ref(clean, bkgd);				dbg_show(3, clean);
+	alx_cv_and_2ref(lvl, tmp);				dbg_show(3, lvl);
+	alx_cv_or_2ref(lvl, bkgd);				dbg_show(3, lvl);
 
-	/* Find syms */
+	/* Find syms (lvl isn't needed any more) */
 	status--;
-	alx_cv_clone(tmp, clean);				dbg_show(3, tmp);
-	alx_cv_extract_imgdata(tmp, NULL, &w, &h, NULL, NULL, NULL);
-	alx_cv_normalize(tmp);					dbg_show(3, tmp);
-	alx_cv_smooth(tmp, ALX_CV_SMOOTH_MEDIAN, 5);		dbg_show(3, tmp);
+	alx_cv_extract_imgdata(lvl, NULL, &w, &h, NULL, NULL, NULL);
+	alx_cv_normalize(lvl);					dbg_show(3, lvl);
+	median_blur(lvl, MEDIAN_NET, 5);			dbg_show(3, lvl);
 	h	= MIN(w, h);
-	alx_cv_adaptive_thr(tmp, ALX_CV_ADAPTIVE_THRESH_GAUSSIAN,
-			ALX_CV_THRESH_BINARY_INV, h / 2, 25);	dbg_show(3, tmp);
-//	alx_cv_canny(tmp, 127, 200, 3, true);			dbg_show(3, tmp);
-	alx_cv_dilate_h(tmp, 1);				dbg_show(3, tmp);
-	alx_cv_dilate(tmp, 1);					dbg_show(3, tmp);
-	alx_cv_holes_fill(tmp);					dbg_show(3, tmp);
+	alx_cv_adaptive_thr(lvl, ALX_CV_ADAPTIVE_THRESH_GAUSSIAN,
+			ALX_CV_THRESH_BINARY_INV, h / 2, 25);	dbg_show(3, lvl);
+//	alx_cv_canny(lvl, 127, 200, 3, true);			dbg_show(3, lvl);
+	morph_dilate_h(lvl, 1);					dbg_show(3, lvl);
+	morph_dilate(lvl, 1);					dbg_show(3, lvl);
+	ccl_holes_fill(lvl);					dbg_show(3, lvl);
 	h	= MIN(w, h);
-	alx_cv_erode_dilate(tmp, h / 35);			dbg_show(3, tmp);
-	alx_cv_dilate_h(tmp, w / 6);				dbg_show(3, tmp);
-	alx_cv_contours(tmp, conts);
-	if (alx_cv_conts_largest_p(&syms, NULL, conts))
-		goto err; 
-	alx_cv_bounding_rect(rect, syms);
+	morph_erode_dilate(lvl, h / 35);			dbg_show(3, lvl);
+	morph_dilate_h(lvl, w / 6);				dbg_show(3, lvl);
+	if (ccl_label(ccl, lvl))
+		goto err;
+	syms	= ccl_largest_p(ccl);
+	if (syms < 0)
+		goto err;
+	ccl_bounding_rect(rect, ccl, syms);
 	alx_cv_extract_rect(rect, NULL, &y, NULL, &h);
 
-	/* Crop to symbols */
+	/* Back to full resolution;  a pixel of lvl is s pixels of img */
+	y	*= s;
+	h	*= s;
+	if (s > 1 && refine_band(img, tmp, ccl, rect, &y, &h, s))
+		goto err;
+
+	/*
+	 * Crop to symbols.  The median needs the line above and below the
+	 * band, as it had when it filtered the whole label.
+	 */
 	status--;
 	y	+= h / 2;
 	h	*= 2;
 	y	-= h / 2;
+	by	= y;
+	bh	= h;
 	x	= 0;
-	if (alx_cv_set_rect(rect, x, y, w, h))
+	y--;
+	h	+= 2;
+	alx_cv_extract_imgdata(img, NULL, &w, NULL, NULL, NULL, NULL);
+	if (cvx_roi_clamp(img, &x, &y, &w, &h))
 		goto err;
-	alx_cv_roi_set(img, rect);		dbg_update_win(); dbg_show(1, img);
+	alx_cv_component(img, ALX_CV_CMP_BGR_R);		dbg_show(3, img);
+	median_blur(img, MEDIAN_NET, 3);
+	by	-= y;
+	if (cvx_roi_clamp(img, &x, &by, &w, &bh))
+		goto err;
+						dbg_update_win(); dbg_show(1, img);
 
 	/* deinit */
 	status	= 0;
-err:	alx_cv_deinit_rect(rect);
-err3:	alx_cv_deinit_conts(conts);
-err2:	alx_cv_deinit_img(tmp);
-err1:	alx_cv_deinit_img(bkgd);
-err0:	alx_cv_deinit_img(clean);
+err:	pool_put_img(lvl);
+err3:	pool_put_rect(rect);
+err2:	pool_put_ccl(ccl);
+err1:	pool_put_img(tmp);
+err0:	pool_put_img(bkgd);
 	return	status;
 }
 
-int	find_symbols_horizontally	(img_s *img)
+int	find_symbols_horizontally	(struct Ctx *ctx)
 {
+	img_s		*img;
 	img_s		*tmp;
-	conts_s		*conts;
-	const cont_s	*syms;
+	struct Ccl	*ccl;
 	rect_s		*rect;
 	ptrdiff_t	x, y, w, h;
+	ptrdiff_t	syms;
 	int		status;
 
 	/* init */
+	img	= ctx->img;
 	status	= -1;
-	if (alx_cv_init_img(&tmp))
+	if (pool_get_img(&tmp))
 		return	status;
-	if (alx_cv_init_conts(&conts))
+	if (pool_get_ccl(&ccl))
 		goto err0;
-	if (alx_cv_init_rect(&rect))
+	if (pool_get_rect(&rect))
 		goto err1;
 
-	/* Find symbols */
+	/* Find symbols (copy only the ROI) */
 	status--;
-	alx_cv_clone(tmp, img);					dbg_show(2, tmp);
+	cvx_view(tmp, img);					dbg_show(2, tmp);
 	alx_cv_extract_imgdata(tmp, NULL, &w, &h, NULL, NULL, NULL);
 	alx_cv_set_rect(rect, 20, 0, w - 40, h);
-	alx_cv_roi_set(tmp, rect);				dbg_show(3, tmp);
+	alx_cv_roi_set(tmp, rect);
+	if (cvx_unshare(tmp))
+		goto err;					dbg_show(3, tmp);
 	alx_cv_normalize(tmp);					dbg_show(3, tmp);
 //	alx_cv_adaptive_thr(tmp, ALX_CV_ADAPTIVE_THRESH_GAUSSIAN,
 //			ALX_CV_THRESH_BINARY_INV, h / 2, 25);	dbg_show(3, tmp);
 	alx_cv_threshold(tmp, ALX_CV_THRESH_BINARY_INV, ALX_CV_THR_OTSU);
 								dbg_show(3, tmp);
-	alx_cv_dilate_h(tmp, w / 35);				dbg_show(3, tmp);
-	alx_cv_dilate_v(tmp, h / 40);				dbg_show(3, tmp);
-	alx_cv_contours(tmp, conts);
-	if (alx_cv_conts_largest_p(&syms, NULL, conts))
+	morph_dilate_h(tmp, w / 35);				dbg_show(3, tmp);
+	morph_dilate_v(tmp, h / 40);				dbg_show(3, tmp);
+	if (ccl_label(ccl, tmp))
+		goto err;
+	syms	= ccl_largest_p(ccl);
+	if (syms < 0)
 		goto err;
-	alx_cv_bounding_rect(rect, syms);
+	ccl_bounding_rect(rect, ccl, syms);
 	alx_cv_extract_rect(rect, &x, NULL, &w, NULL);
 
 	/* Crop to symbols */
@@ -214,14 +287,15 @@ int	find_symbols_horizontally	(img_s *img)
 
 	/* deinit */
 	status	= 0;
-err:	alx_cv_deinit_rect(rect);
-err1:	alx_cv_deinit_conts(conts);
-err0:	alx_cv_deinit_img(tmp);
+err:	pool_put_rect(rect);
+err1:	pool_put_ccl(ccl);
+err0:	pool_put_img(tmp);
 	return	status;
 }
 
-int	align_symbols			(img_s *img)
+int	align_symbols			(struct Ctx *ctx)
 {
+	img_s		*img;
 	img_s		*tmp;
 	conts_s		*conts;
 	const cont_s	*syms;
@@ -231,14 +305,15 @@ int	align_symbols			(img_s *img)
 	int		status;
 
 	/* init */
+	img	= ctx->img;
 	status	= -1;
-	if (alx_cv_init_img(&tmp))
+	if (pool_get_img(&tmp))
 		return	status;
-	if (alx_cv_init_conts(&conts))
+	if (pool_get_conts(&conts))
 		goto err0;
-	if (alx_cv_init_rect_rot(&rect_rot))
+	if (pool_get_rect_rot(&rect_rot))
 		goto err1;
-	if (alx_cv_init_rect(&rect))
+	if (pool_get_rect(&rect))
 		goto err2;
 
 	/* Find symbols */
@@ -250,8 +325,8 @@ int	align_symbols			(img_s *img)
 			ALX_CV_THRESH_BINARY_INV, h, 25);	dbg_show(3, tmp);
 //	alx_cv_threshold(tmp, ALX_CV_THRESH_BINARY_INV, ALX_CV_THR_OTSU);
 //								dbg_show(3, tmp);
-	alx_cv_dilate_h(tmp, w / 30);				dbg_show(3, tmp);
-	alx_cv_dilate_v(tmp, h / 40);				dbg_show(3, tmp);
+	morph_dilate_h(tmp, w / 30);				dbg_show(3, tmp);
+	morph_dilate_v(tmp, h / 40);				dbg_show(3, tmp);
 	alx_cv_contours(tmp, conts);
 	if (alx_cv_conts_largest_p(&syms, NULL, conts))
 		goto err;
@@ -263,10 +338,10 @@ int	align_symbols			(img_s *img)
 
 	/* deinit */
 	status	= 0;
-err:	alx_cv_deinit_rect(rect);
-err2:	alx_cv_deinit_rect_rot(rect_rot);
-err1:	alx_cv_deinit_conts(conts);
-err0:	alx_cv_deinit_img(tmp);
+err:	pool_put_rect(rect);
+err2:	pool_put_rect_rot(rect_rot);
+err1:	pool_put_conts(conts);
+err0:	pool_put_img(tmp);
 	return	status;
 }
 
@@ -274,6 +349,117 @@ err0:	alx_cv_deinit_img(tmp);
 /******************************************************************************
  ******* static function definitions ******************************************
  ******************************************************************************/
+/*
+ * Scale (a power of 2) of the smallest pyramid level whose shorter side still
+ * has at least min_px pixels.
+ */
+static
+int	pyr_scale			(ptrdiff_t w, ptrdiff_t h,
+					 ptrdiff_t min_px)
+{
+	int	s;
+
+	for (s = 1; MIN(w, h) / (s * 2) >= min_px; s *= 2)
+		;
+	return	s;
+}
+
+/*
+ * The band (*y, *h) was found at scale s, so each of its edges is within s
+ * lines of where it would be at full resolution.  Find the band again in
+ * img as find_symbols_vertically() does in lvl, but only in those lines,
+ * and with the sizes of the whole label.  A band found there that doesn't
+ * overlap the first one is ignored.
+ */
+static
+int	refine_band			(const img_s *restrict img,
+					 img_s *restrict tmp,
+					 struct Ccl *restrict ccl,
+					 rect_s *restrict rect,
+					 ptrdiff_t *restrict y,
+					 ptrdiff_t *restrict h, int s)
+{
+	ptrdiff_t	x, w, m;
+	ptrdiff_t	by, bh;
+	ptrdiff_t	ry, rh;
+	ptrdiff_t	band;
+
+	alx_cv_extract_imgdata(img, NULL, &w, &m, NULL, NULL, NULL);
+	m	= MIN(w, m);
+	x	= 0;
+	by	= *y - s;
+	bh	= *h + 2 * s;
+	cvx_view(tmp, img);
+	if (cvx_roi_clamp(tmp, &x, &by, &w, &bh))
+		return	-1;
+	if (cvx_unshare(tmp))
+		return	-1;					dbg_show(3, tmp);
+	alx_cv_component(tmp, ALX_CV_CMP_BGR_R);		dbg_show(3, tmp);
+	median_blur(tmp, MEDIAN_NET, 3);			dbg_show(3, tmp);
+	alx_cv_normalize(tmp);					dbg_show(3, tmp);
+	median_blur(tmp, MEDIAN_NET, 5);			dbg_show(3, tmp);
+	alx_cv_adaptive_thr(tmp, ALX_CV_ADAPTIVE_THRESH_GAUSSIAN,
+			ALX_CV_THRESH_BINARY_INV, m / 2, 25);	dbg_show(3, tmp);
+	morph_dilate_h(tmp, 1);					dbg_show(3, tmp);
+	morph_dilate(tmp, 1);					dbg_show(3, tmp);
+	ccl_holes_fill(tmp);					dbg_show(3, tmp);
+	morph_erode_dilate(tmp, m / 35);			dbg_show(3, tmp);
+	morph_dilate_h(tmp, w / 6);				dbg_show(3, tmp);
+	if (ccl_label(ccl, tmp))
+		return	-1;
+	band	= ccl_largest_p(ccl);
+	if (band < 0)
+		return	0;
+	ccl_bounding_rect(rect, ccl, band);
+	alx_cv_extract_rect(rect, NULL, &ry, NULL, &rh);
+	ry	+= by;
+	if (ry >= *y + *h || ry + rh <= *y)
+		return	0;
+
+	*y	= ry;
+	*h	= rh;
+	return	0;
+}
+
+/*
+ * Scale rect_rot (found in ctx->lbl) to full resolution, and leave in
+ * ctx->img the region around it, with rect_rot relative to that region.
+ * The region has room for the label both as it is and once aligned.
+ */
+static
+int	crop_label			(struct Ctx *restrict ctx,
+					 rect_rot_s *restrict rect_rot)
+{
+	double		cx, cy, rw, rh, angle;
+	double		a, l;
+	ptrdiff_t	x, y, w, h;
+	int		s;
+	int		status;
+
+	s	= ctx->scale;
+	cvx_extract_rect_rot(rect_rot, &cx, &cy, &rw, &rh, &angle);
+	cx	*= s;
+	cy	*= s;
+	rw	*= s;
+	rh	*= s;
+	a	= angle * M_PI / 180;
+	l	= MAX(rw, rh);
+	w	= MAX(fabs(rw * cos(a)) + fabs(rh * sin(a)), l) + 2 * s;
+	h	= MAX(fabs(rw * sin(a)) + fabs(rh * cos(a)), l) + 2 * s;
+	x	= cx - w / 2;
+	y	= cy - h / 2;
+
+	if (ctx->crop)
+		status	= decode_jpeg_crop(ctx->img, ctx->buf, ctx->size,
+							&x, &y, &w, &h);
+	else
+		status	= cvx_roi_clamp(ctx->img, &x, &y, &w, &h);
+	if (status)
+		return	status;
+	cvx_set_rect_rot(rect_rot, cx - x, cy - y, rw, rh, angle);
+
+	return	0;
+}
 
 
 /******************************************************************************
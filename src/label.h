@@ -13,12 +13,16 @@
 /******************************************************************************
  ******* headers **************************************************************
  ******************************************************************************/
-#include <libalx/extra/cv/cv.h>
+#include "ctx.h"
 
 
 /******************************************************************************
  ******* macros ***************************************************************
  ******************************************************************************/
+/* The label is found in an image reduced down to about this size */
+#define LABEL_MIN_PX	(320)
+/* The band of symbols is found in a copy of the label reduced down to this */
+#define SYMS_MIN_PX	(240)
 
 
 /******************************************************************************
@@ -34,10 +38,10 @@
 /******************************************************************************
  ******* prototypes ***********************************************************
  ******************************************************************************/
-int	find_label			(img_s *img);
-int	find_symbols_vertically		(img_s *img);
-int	find_symbols_horizontally	(img_s *img);
-int	align_symbols			(img_s *img);
+int	find_label			(struct Ctx *ctx);
+int	find_symbols_vertically		(struct Ctx *ctx);
+int	find_symbols_horizontally	(struct Ctx *ctx);
+int	align_symbols			(struct Ctx *ctx);
 
 
 /******************************************************************************
@@ -0,0 +1,135 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "laundry-symbol-reader.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/extra/cv/cv.h>
+
+#include "ctx.h"
+#include "reader.h"
+#include "templates/templates.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+static_assert(LSR_MAX_SYMBOLS == MAX_SYMBOLS, "LSR_MAX_SYMBOLS");
+static_assert(LSR_CODE_BASE_POS == CODE_BASE_POS, "LSR_CODE_BASE_POS");
+static_assert(LSR_CODE_BASE_LEN == CODE_BASE_LEN, "LSR_CODE_BASE_LEN");
+static_assert(LSR_CODE_Y_N_POS == CODE_Y_N_POS, "LSR_CODE_Y_N_POS");
+static_assert(LSR_CODE_IN_POS == CODE_IN_POS, "LSR_CODE_IN_POS");
+static_assert(LSR_CODE_IN_LEN == CODE_IN_LEN, "LSR_CODE_IN_LEN");
+static_assert(LSR_CODE_OUT_POS == CODE_OUT_POS, "LSR_CODE_OUT_POS");
+static_assert(LSR_CODE_OUT_LEN == CODE_OUT_LEN, "LSR_CODE_OUT_LEN");
+static_assert((int)LSR_BASE_WASH == (int)T_BASE_WASH, "LSR_BASE_WASH");
+static_assert((int)LSR_BASE_BLEACH == (int)T_BASE_BLEACH, "LSR_BASE_BLEACH");
+static_assert((int)LSR_BASE_DRY == (int)T_BASE_DRY, "LSR_BASE_DRY");
+static_assert((int)LSR_BASE_IRON == (int)T_BASE_IRON, "LSR_BASE_IRON");
+static_assert((int)LSR_BASE_PRO == (int)T_BASE_PRO, "LSR_BASE_PRO");
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+/* The public types are the internal ones under another name */
+struct	Lsr_Templates {
+	struct Templates	t;
+};
+
+struct	Lsr_Reader {
+	struct Ctx	ctx;
+};
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+int	lsr_templates_init	(struct Lsr_Templates **t, const char *dir)
+{
+	struct Templates	*tt;
+
+	if (init_templates(&tt))
+		return	-1;
+	if (load_templates(tt, dir ? dir : TEMPLATES_DIR)) {
+		deinit_templates(tt);
+		return	-1;
+	}
+
+	*t	= (struct Lsr_Templates *)tt;
+	return	0;
+}
+
+void	lsr_templates_deinit	(struct Lsr_Templates *t)
+{
+
+	deinit_templates(&t->t);
+}
+
+int	lsr_reader_init		(struct Lsr_Reader **r,
+				 const struct Lsr_Templates *t)
+{
+	struct Ctx	*ctx;
+
+	if (init_ctx(&ctx, &t->t))
+		return	-1;
+
+	*r	= (struct Lsr_Reader *)ctx;
+	return	0;
+}
+
+void	lsr_reader_deinit	(struct Lsr_Reader *r)
+{
+
+	deinit_ctx(&r->ctx);
+}
+
+int	lsr_read_file		(struct Lsr_Reader *restrict r,
+				 const char *restrict fname,
+				 uint32_t codes[LSR_MAX_SYMBOLS],
+				 ptrdiff_t *restrict n)
+{
+
+	return	read_file(&r->ctx, fname, codes, n);
+}
+
+int	lsr_read_buf		(struct Lsr_Reader *restrict r,
+				 const void *restrict buf, size_t size,
+				 uint32_t codes[LSR_MAX_SYMBOLS],
+				 ptrdiff_t *restrict n)
+{
+
+	return	read_buf(&r->ctx, buf, size, codes, n);
+}
+
+void	lsr_fprint_code		(FILE *stream, uint32_t code)
+{
+
+	fprint_code(stream, code);
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -7,8 +7,18 @@
 /******************************************************************************
  ******* headers **************************************************************
  ******************************************************************************/
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <getopt.h>
+#include <sys/param.h>
+#include <unistd.h>
 
 #define ALX_NO_PREFIX
 #include <libalx/base/compiler.h>
@@ -17,15 +27,23 @@
 #include <libalx/extra/cv/cv.h>
 
 #include "dbg.h"
-#include "label.h"
+#include "batch.h"
+#include "cache.h"
+#include "ctx.h"
+#include "prof.h"
+#include "reader.h"
+#include "server.h"
 #include "symbols.h"
-#include "templates/base.h"
+#include "tasks.h"
+#include "templates/bundle.h"
 #include "templates/templates.h"
 
 
 /******************************************************************************
  ******* macro ****************************************************************
  ******************************************************************************/
+/* Largest -j;  more threads than that is surely a typo */
+#define NTHR_MAX	(1024)
 
 
 /******************************************************************************
@@ -33,74 +51,189 @@
  ******************************************************************************/
 
 
+/******************************************************************************
+ ******* variables ************************************************************
+ ******************************************************************************/
+static const struct option	long_opts[]	= {
+	{"profile",	optional_argument,	NULL,	'p'},
+	{"debug",	required_argument,	NULL,	'd'},
+	{"debug-dir",	required_argument,	NULL,	'D'},
+	{"debug-sample",required_argument,	NULL,	'S'},
+	{"cache",	required_argument,	NULL,	'c'},
+	{NULL,		0,			NULL,	0}
+};
+
+
 /******************************************************************************
  ******* static functions (prototypes) ****************************************
  ******************************************************************************/
 static
-int	init	(img_s **restrict img);
+int	init	(struct Templates **restrict t, struct Ctx **restrict ctx,
+		 int dbg, const char *restrict dbg_dir, int dbg_sample);
 static
-void	deinit	(img_s *restrict img);
+void	deinit	(struct Templates *restrict t, struct Ctx *restrict ctx);
+static
+int	parse_int	(int *restrict n, const char *restrict str,
+			 int min, int max);
 
 
 /******************************************************************************
  ******* main *****************************************************************
  ******************************************************************************/
+/*
+ * laundry-symbol-reader [--profile[=hw]] [--cache=<file>] [-j <threads>] <image> | -
+ * laundry-symbol-reader [--profile[=hw]] [--cache=<file>] -b [-j <threads>] [<image> | <dir> | -]...
+ * laundry-symbol-reader [--profile[=hw]] [--cache=<file>] [-j <threads>] -s <socket>
+ * laundry-symbol-reader -C <templates dir>
+ *
+ * --profile prints the time of every stage to stderr (see prof_fprint()),
+ * and =hw adds the hardware counters.
+ *
+ * -j is the number of threads:  in batch mode, that read images (1 by
+ * default);  otherwise, that read the symbols of the label (by default, one
+ * per online CPU, up to MAX_SYMBOLS).  0 is one per online CPU.
+ *
+ * --debug=<level> (1 to 4) shows the images of the stages (see dbg.h);  with
+ * --debug-dir=<dir> they are written to dir instead, and with
+ * --debug-sample=<n> only one request in every n is debugged.  Batch mode
+ * needs a dir.
+ *
+ * --cache=<file> keeps the results in file (created if needed), shared with
+ * other processes, and reads images already in it from there (see cache.h).
+ * If the file can't be used, there's a warning, and no cache.
+ */
 int	main	(int argc, char *argv[])
 {
-	const char	*fname;
-	img_s		*img;
-	uint32_t	code;
-	int		status;
+	const char		*fname;
+	const char		*sock;
+	const char		*bundle;
+	const char		*ddir;
+	const char		*cache;
+	struct Templates	*t;
+	struct Ctx		*ctx;
+	uint32_t		codes[MAX_SYMBOLS];
+	ptrdiff_t		n;
+	bool			bat;
+	int			nthr;
+	int			prof;
+	int			dbg;
+	int			dsample;
+	int			opt;
+	int			s;
+	int			status;
 
 	status	= 1;
-	if (argc != 2)
-		return	1;
-	fname	= argv[1];
+	sock	= NULL;
+	bundle	= NULL;
+	ddir	= NULL;
+	cache	= NULL;
+	bat	= false;
+	nthr	= -1;
+	prof	= PROF_OFF;
+	dbg	= 0;
+	dsample	= 1;
+	while ((opt = getopt_long(argc, argv, "bC:j:s:", long_opts, NULL)) != -1) {
+		switch (opt) {
+		case 'b':
+			bat	= true;
+			break;
+		case 'C':
+			bundle	= optarg;
+			break;
+		case 'j':
+			if (parse_int(&nthr, optarg, 0, NTHR_MAX))
+				return	status;
+			break;
+		case 's':
+			sock	= optarg;
+			break;
+		case 'p':
+			if (!optarg)
+				prof	= PROF_WALL;
+			else if (!strcmp(optarg, "hw"))
+				prof	= PROF_HW;
+			else
+				return	status;
+			break;
+		case 'd':
+			if (parse_int(&dbg, optarg, 0, INT_MAX))
+				return	status;
+			break;
+		case 'D':
+			ddir	= optarg;
+			break;
+		case 'S':
+			if (parse_int(&dsample, optarg, 1, INT_MAX))
+				return	status;
+			break;
+		case 'c':
+			cache	= optarg;
+			break;
+		default:
+			return	status;
+		}
+	}
+	if (!!bat + !!sock + !!bundle > 1)
+		return	status;
+	if (!bat && argc - optind != !(sock || bundle))
+		return	status;
+	/* Only one thread can show the window */
+	if (bat && dbg > 0 && !ddir)
+		return	status;
+	fname	= argv[optind];
 	status++;
-	if (init(&img))
+	if (init(&t, &ctx, dbg, ddir, dsample))
 		goto err0;
-
-	status++;
-	if (load_templates())
-		goto err;
-	status++;
-	if (alx_cv_imread(img, fname))
-		goto err;
-	status++;
-	if (find_label(img))
-		goto err;
-	status++;
-	if (find_symbols_vertically(img))
-		goto err;
-	status++;
-	if (find_symbols_horizontally(img))
-		goto err;
-	status++;
-	if (align_symbols(img))
-		goto err;
-	status++;
-	if (extract_symbols(img))
+	if (init_prof(&ctx->prof, prof))
 		goto err;
+	if (!bat && !bundle) {
+		if (nthr < 1)
+			nthr	= sysconf(_SC_NPROCESSORS_ONLN);
+		if (init_tasks(&ctx->tasks, MIN(nthr, MAX_SYMBOLS)))
+			goto err;
+	}
+
 	status++;
-	for (ptrdiff_t i = 0; i < nsyms; i++) {
-		code	= 0;
-		if (clean_symbol(symbols[i]))
+	if (bundle) {
+		if (load_templates_png(t, bundle))
 			goto err;
-		if (match_t_base(symbols[i], &code, i))
+		if (t_bundle_write(t, bundle))
 			goto err;
-		if (match_t_inner(symbols[i], &code) < 0)
+		goto out;
+	}
+	if (load_templates(t, TEMPLATES_DIR))
+		goto err;
+	status++;
+	/* Optional:  if it can't be used, init_cache() warns, and that's all */
+	if (!bat)
+		init_cache(&ctx->cache, cache, t);
+	if (sock) {
+		if (serve(sock, ctx))
 			goto err;
-		if (match_t_outer(symbols[i], &code) < 0)
+		goto out;
+	}
+	if (bat) {
+		if (batch(t, nthr < 0 ? 1 : nthr, prof, cache,
+					&argv[optind], argc - optind))
 			goto err;
-		print_code(code);
+		goto out;
+	}
+	if (!strcmp(fname, "-"))
+		s	= read_stream(ctx, stdin, codes, &n);
+	else
+		s	= read_file(ctx, fname, codes, &n);
+	prof_fprint(stderr, ctx->prof, fname);
+	for (ptrdiff_t i = 0; i < n; i++)
+		print_code(codes[i]);
+	if (s) {
+		status	= s;
+		goto err;
 	}
 
-	alx_cv_imwrite(img, "/tmp/wash.png");
-
-	deinit(img);
+out:	deinit(t, ctx);
 	return	0;
 err:
-	deinit(img);
+	deinit(t, ctx);
 err0:
 	fprintf(stderr, "Error reading label\n");
 	return	status;
@@ -111,34 +244,48 @@ err0:
  ******* static functions (definitions) ***************************************
  ******************************************************************************/
 static
-int	init	(img_s **restrict img)
+int	init	(struct Templates **restrict t, struct Ctx **restrict ctx,
+		 int dbg, const char *restrict dbg_dir, int dbg_sample)
 {
 
-	if (alx_cv_init_img(img))
+	if (init_dbg(dbg, dbg_dir, dbg_sample))
 		return	-1;
-	if (init_symbols())
+	if (init_templates(t))
 		goto err0;
-	if (init_templates())
+	if (init_ctx(ctx, *t))
 		goto err1;
-	if (DBG)
-		alx_cv_named_window("dbg", ALX_CV_WINDOW_NORMAL);
 
 	return	0;
 
-err1:	deinit_symbols();
-err0:	alx_cv_deinit_img(*img);
+err1:	deinit_templates(*t);
+err0:	deinit_dbg();
 	return	-1;
 }
 
 static
-void	deinit	(img_s *restrict img)
+void	deinit	(struct Templates *restrict t, struct Ctx *restrict ctx)
 {
 
-	if (DBG)
-		alx_cv_destroy_all_windows();
-	deinit_templates();
-	deinit_symbols();
-	alx_cv_deinit_img(img);
+	deinit_ctx(ctx);
+	deinit_templates(t);
+	deinit_dbg();
+}
+
+
+/* A whole decimal number in [min, max] */
+static
+int	parse_int	(int *restrict n, const char *restrict str,
+			 int min, int max)
+{
+	char	*end;
+	long	l;
+
+	errno	= 0;
+	l	= strtol(str, &end, 10);
+	if (errno || end == str || *end || l < min || l > max)
+		return	-1;
+	*n	= l;
+	return	0;
 }
 
 
@@ -0,0 +1,314 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "median.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <sys/param.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "pool.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+#define MEDIAN_KMAX	(5)
+
+/*
+ * op(a, b) sorts p[a] and p[b];  at the end, the median is in p[4] (3x3) or
+ * p[12] (5x5).  The other elements are only partially sorted.  The networks
+ * are those of Paeth (3x3) and Devillard (5x5).
+ */
+#define MEDIAN_NET9(op)							\
+	op(1, 2)  op(4, 5)  op(7, 8)  op(0, 1)  op(3, 4)		\
+	op(6, 7)  op(1, 2)  op(4, 5)  op(7, 8)  op(0, 3)		\
+	op(5, 8)  op(4, 7)  op(3, 6)  op(1, 4)  op(2, 5)		\
+	op(4, 7)  op(4, 2)  op(6, 4)  op(4, 2)
+
+#define MEDIAN_NET25(op)						\
+	op(0, 1)   op(3, 4)   op(2, 4)   op(2, 3)   op(6, 7)		\
+	op(5, 7)   op(5, 6)   op(9, 10)  op(8, 10)  op(8, 9)		\
+	op(12, 13) op(11, 13) op(11, 12) op(15, 16) op(14, 16)		\
+	op(14, 15) op(18, 19) op(17, 19) op(17, 18) op(21, 22)		\
+	op(20, 22) op(20, 21) op(23, 24) op(2, 5)   op(3, 6)		\
+	op(0, 6)   op(0, 3)   op(4, 7)   op(1, 7)   op(1, 4)		\
+	op(11, 14) op(8, 14)  op(8, 11)  op(12, 15) op(9, 15)		\
+	op(9, 12)  op(13, 16) op(10, 16) op(10, 13) op(20, 23)		\
+	op(17, 23) op(17, 20) op(21, 24) op(18, 24) op(18, 21)		\
+	op(19, 22) op(8, 17)  op(9, 18)  op(0, 18)  op(0, 9)		\
+	op(10, 19) op(1, 19)  op(1, 10)  op(11, 20) op(2, 20)		\
+	op(2, 11)  op(12, 21) op(3, 21)  op(3, 12)  op(13, 22)		\
+	op(4, 22)  op(4, 13)  op(14, 23) op(5, 23)  op(5, 14)		\
+	op(15, 24) op(6, 24)  op(6, 15)  op(7, 16)  op(7, 19)		\
+	op(13, 21) op(15, 23) op(7, 13)  op(7, 15)  op(1, 9)		\
+	op(3, 11)  op(5, 17)  op(11, 17) op(9, 17)  op(4, 10)		\
+	op(6, 12)  op(7, 14)  op(4, 6)   op(4, 7)   op(12, 14)		\
+	op(10, 14) op(6, 7)   op(10, 12) op(6, 10)  op(6, 17)		\
+	op(12, 17) op(7, 17)  op(7, 10)  op(12, 18) op(7, 12)		\
+	op(10, 18) op(12, 20) op(10, 20) op(10, 12)
+
+#define MEDIAN_OP_U8(a, b)						\
+{									\
+	uint8_t	t_;							\
+									\
+	t_	= MIN(p[a], p[b]);					\
+	p[b]	= MAX(p[a], p[b]);					\
+	p[a]	= t_;							\
+}
+
+#define MEDIAN_OP_SSE2(a, b)						\
+{									\
+	__m128i	t_;							\
+									\
+	t_	= _mm_min_epu8(p[a], p[b]);				\
+	p[b]	= _mm_max_epu8(p[a], p[b]);				\
+	p[a]	= t_;							\
+}
+
+#define MEDIAN_OP_AVX2(a, b)						\
+{									\
+	__m256i	t_;							\
+									\
+	t_	= _mm256_min_epu8(p[a], p[b]);				\
+	p[b]	= _mm256_max_epu8(p[a], p[b]);				\
+	p[a]	= t_;							\
+}
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+int	median_net	(img_s *img, int ksize);
+static
+void	pad_line	(uint8_t *restrict dst, const uint8_t *restrict src,
+			 ptrdiff_t w, ptrdiff_t r);
+static
+void	median_line	(uint8_t *restrict dst,
+			 const uint8_t *const rows[restrict MEDIAN_KMAX],
+			 ptrdiff_t w, int ksize);
+static
+ptrdiff_t median_line_c	(uint8_t *restrict dst,
+			 const uint8_t *const rows[restrict MEDIAN_KMAX],
+			 ptrdiff_t x, ptrdiff_t w, int ksize);
+#if defined(__x86_64__)
+static
+ptrdiff_t median_line_sse2(uint8_t *restrict dst,
+			 const uint8_t *const rows[restrict MEDIAN_KMAX],
+			 ptrdiff_t x, ptrdiff_t w, int ksize);
+static
+ptrdiff_t median_line_avx2(uint8_t *restrict dst,
+			 const uint8_t *const rows[restrict MEDIAN_KMAX],
+			 ptrdiff_t x, ptrdiff_t w, int ksize);
+#endif
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+void	median_blur	(img_s *img, int method, int ksize)
+{
+
+	switch (method) {
+	case MEDIAN_NET:
+		if (!median_net(img, ksize))
+			return;
+		alx_cv_smooth(img, ALX_CV_SMOOTH_MEDIAN, ksize);
+		return;
+	case MEDIAN_ALX:
+	default:
+		alx_cv_smooth(img, ALX_CV_SMOOTH_MEDIAN, ksize);
+		return;
+	}
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+/*
+ * The lines are filtered in place, so the ksize lines around the current
+ * one are kept in a ring of copies, padded with r replicated pixels on each
+ * side.  Line y is copied (to slot y % ksize) before line y - r is written.
+ */
+static
+int	median_net	(img_s *img, int ksize)
+{
+	const uint8_t	*rows[MEDIAN_KMAX];
+	uint8_t		*data, *ring;
+	void		*d;
+	ptrdiff_t	w, h, B_per_pix, B_per_line;
+	ptrdiff_t	r, pw;
+
+	if (ksize != 3 && ksize != 5)
+		return	-1;
+	alx_cv_extract_imgdata(img, &d, &w, &h, &B_per_pix, &B_per_line, NULL);
+	if (B_per_pix != 1 || !w || !h)
+		return	-1;
+	data	= d;
+	r	= ksize / 2;
+	pw	= w + 2 * r;
+	ring	= pool_get_buf(ksize * pw);
+	if (!ring)
+		return	-1;
+
+	for (ptrdiff_t y = 0; y < MIN(r, h); y++)
+		pad_line(ring + y % ksize * pw, data + y * B_per_line, w, r);
+	for (ptrdiff_t y = 0; y < h; y++) {
+		if (y + r < h) {
+			pad_line(ring + (y + r) % ksize * pw,
+					data + (y + r) * B_per_line, w, r);
+		}
+		for (ptrdiff_t i = 0; i < ksize; i++)
+			rows[i]	= ring + MIN(MAX(y - r + i, 0), h - 1) % ksize * pw;
+		median_line(data + y * B_per_line, rows, w, ksize);
+	}
+
+	pool_put_buf(ring);
+	return	0;
+}
+
+static
+void	pad_line	(uint8_t *restrict dst, const uint8_t *restrict src,
+			 ptrdiff_t w, ptrdiff_t r)
+{
+
+	memset(dst, src[0], r);
+	memcpy(dst + r, src, w);
+	memset(dst + r + w, src[w - 1], r);
+}
+
+/* Pixel x of dst is the median of rows[0 .. ksize-1][x .. x+ksize-1] */
+static
+void	median_line	(uint8_t *restrict dst,
+			 const uint8_t *const rows[restrict MEDIAN_KMAX],
+			 ptrdiff_t w, int ksize)
+{
+	ptrdiff_t	x;
+
+	x	= 0;
+#if defined(__x86_64__)
+	if (__builtin_cpu_supports("avx2"))
+		x	= median_line_avx2(dst, rows, x, w, ksize);
+	x	= median_line_sse2(dst, rows, x, w, ksize);
+#endif
+	median_line_c(dst, rows, x, w, ksize);
+}
+
+/* Pixels [x, w);  returns w */
+static
+ptrdiff_t median_line_c	(uint8_t *restrict dst,
+			 const uint8_t *const rows[restrict MEDIAN_KMAX],
+			 ptrdiff_t x, ptrdiff_t w, int ksize)
+{
+	uint8_t	p[MEDIAN_KMAX * MEDIAN_KMAX];
+
+	for (; x < w; x++) {
+		for (int i = 0; i < ksize; i++) {
+			for (int j = 0; j < ksize; j++)
+				p[i * ksize + j]	= rows[i][x + j];
+		}
+		if (ksize == 3) {
+			MEDIAN_NET9(MEDIAN_OP_U8)
+			dst[x]	= p[4];
+		} else {
+			MEDIAN_NET25(MEDIAN_OP_U8)
+			dst[x]	= p[12];
+		}
+	}
+	return	x;
+}
+
+#if defined(__x86_64__)
+/* 16 pixels at a time from x, while they fit;  returns where it stopped */
+static
+ptrdiff_t median_line_sse2(uint8_t *restrict dst,
+			 const uint8_t *const rows[restrict MEDIAN_KMAX],
+			 ptrdiff_t x, ptrdiff_t w, int ksize)
+{
+	__m128i	p[MEDIAN_KMAX * MEDIAN_KMAX];
+
+	if (ksize == 3) {
+		for (; x + 16 <= w; x += 16) {
+			for (int i = 0; i < 3; i++) {
+				for (int j = 0; j < 3; j++)
+					p[i * 3 + j]	= _mm_loadu_si128(
+						(const __m128i *)&rows[i][x + j]);
+			}
+			MEDIAN_NET9(MEDIAN_OP_SSE2)
+			_mm_storeu_si128((__m128i *)&dst[x], p[4]);
+		}
+	} else {
+		for (; x + 16 <= w; x += 16) {
+			for (int i = 0; i < 5; i++) {
+				for (int j = 0; j < 5; j++)
+					p[i * 5 + j]	= _mm_loadu_si128(
+						(const __m128i *)&rows[i][x + j]);
+			}
+			MEDIAN_NET25(MEDIAN_OP_SSE2)
+			_mm_storeu_si128((__m128i *)&dst[x], p[12]);
+		}
+	}
+	return	x;
+}
+
+/* 32 pixels at a time from x, while they fit;  returns where it stopped */
+__attribute__((target("avx2")))
+static
+ptrdiff_t median_line_avx2(uint8_t *restrict dst,
+			 const uint8_t *const rows[restrict MEDIAN_KMAX],
+			 ptrdiff_t x, ptrdiff_t w, int ksize)
+{
+	__m256i	p[MEDIAN_KMAX * MEDIAN_KMAX];
+
+	if (ksize == 3) {
+		for (; x + 32 <= w; x += 32) {
+			for (int i = 0; i < 3; i++) {
+				for (int j = 0; j < 3; j++)
+					p[i * 3 + j]	= _mm256_loadu_si256(
+						(const __m256i *)&rows[i][x + j]);
+			}
+			MEDIAN_NET9(MEDIAN_OP_AVX2)
+			_mm256_storeu_si256((__m256i *)&dst[x], p[4]);
+		}
+	} else {
+		for (; x + 32 <= w; x += 32) {
+			for (int i = 0; i < 5; i++) {
+				for (int j = 0; j < 5; j++)
+					p[i * 5 + j]	= _mm256_loadu_si256(
+						(const __m256i *)&rows[i][x + j]);
+			}
+			MEDIAN_NET25(MEDIAN_OP_AVX2)
+			_mm256_storeu_si256((__m256i *)&dst[x], p[12]);
+		}
+	}
+	return	x;
+}
+#endif
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,65 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* median.h */
+
+
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * 3x3 and 5x5 median filters of 8-bit single channel images, with the border
+ * replicated, like cv::medianBlur() (the output is the same, bit by bit).
+ * Every pixel is the middle output of a fixed network of min/max (19 of them
+ * for 3x3, 99 for 5x5), without branches, so 16 (SSE2) or 32 (AVX2) pixels
+ * are filtered at once.  Other images (or sizes, or a failure to allocate)
+ * fall back to libalx.
+ */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <libalx/extra/cv/cv.h>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+enum	Median_Method {
+	MEDIAN_ALX,	/* alx_cv_smooth(), ALX_CV_SMOOTH_MEDIAN */
+	MEDIAN_NET
+};
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+/* Same as alx_cv_smooth(img, ALX_CV_SMOOTH_MEDIAN, ksize), by method */
+void	median_blur	(img_s *img, int method, int ksize);
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,268 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "morph.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/param.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "pool.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+/* n pixels, padded with i at both sides, rounded up to blocks of 2i+1 */
+#define morph_len(n, i)	(((n) + 4 * (i)) / (2 * (i) + 1) * (2 * (i) + 1))
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+/* An 8-bit single channel image, or a ROI of one */
+struct	Morph_Img {
+	uint8_t		*data;
+	ptrdiff_t	w;
+	ptrdiff_t	h;
+	ptrdiff_t	step;
+};
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+int	morph_img	(struct Morph_Img *restrict m, img_s *restrict img);
+static
+void	invert		(const struct Morph_Img *m);
+static
+int	dilate		(const struct Morph_Img *m, ptrdiff_t ih, ptrdiff_t iv);
+static
+void	dilate_rows	(const struct Morph_Img *restrict m, ptrdiff_t i,
+			 uint8_t *restrict buf);
+static
+void	dilate_cols	(const struct Morph_Img *restrict m, ptrdiff_t i,
+			 uint8_t *restrict buf);
+static
+int	erode		(const struct Morph_Img *m, ptrdiff_t ih, ptrdiff_t iv);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+void	morph_dilate		(img_s *img, ptrdiff_t i)
+{
+	struct Morph_Img	m;
+
+	if (morph_img(&m, img) || dilate(&m, i, i))
+		alx_cv_dilate(img, i);
+}
+
+void	morph_erode		(img_s *img, ptrdiff_t i)
+{
+	struct Morph_Img	m;
+
+	if (morph_img(&m, img) || erode(&m, i, i))
+		alx_cv_erode(img, i);
+}
+
+void	morph_dilate_h		(img_s *img, ptrdiff_t i)
+{
+	struct Morph_Img	m;
+
+	if (morph_img(&m, img) || dilate(&m, i, 0))
+		alx_cv_dilate_h(img, i);
+}
+
+void	morph_dilate_v		(img_s *img, ptrdiff_t i)
+{
+	struct Morph_Img	m;
+
+	if (morph_img(&m, img) || dilate(&m, 0, i))
+		alx_cv_dilate_v(img, i);
+}
+
+void	morph_dilate_erode	(img_s *img, ptrdiff_t i)
+{
+
+	morph_dilate(img, i);
+	morph_erode(img, i);
+}
+
+void	morph_erode_dilate	(img_s *img, ptrdiff_t i)
+{
+
+	morph_erode(img, i);
+	morph_dilate(img, i);
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+static
+int	morph_img	(struct Morph_Img *restrict m, img_s *restrict img)
+{
+	void		*data;
+	ptrdiff_t	B_per_pix;
+
+	alx_cv_extract_imgdata(img, &data, &m->w, &m->h, &B_per_pix,
+							&m->step, NULL);
+	if (B_per_pix != 1)
+		return	-1;
+	m->data	= data;
+	return	0;
+}
+
+static
+void	invert		(const struct Morph_Img *m)
+{
+	uint8_t	*row;
+
+	for (ptrdiff_t y = 0; y < m->h; y++) {
+		row	= m->data + y * m->step;
+		for (ptrdiff_t x = 0; x < m->w; x++)
+			row[x]	= ~row[x];
+	}
+}
+
+/*
+ * A rectangle is a line of ih in every row and then one of iv in every
+ * column.  The memory for both passes is allocated first, so that a failure
+ * leaves the image untouched.
+ */
+static
+int	dilate		(const struct Morph_Img *m, ptrdiff_t ih, ptrdiff_t iv)
+{
+	uint8_t		*buf;
+	ptrdiff_t	sz_h, sz_v;
+
+	ih	= MAX(ih, 0);
+	iv	= MAX(iv, 0);
+	sz_h	= 3 * morph_len(m->w, ih);
+	sz_v	= (2 * morph_len(m->h, iv) + 1) * m->w;
+	buf	= pool_get_buf(MAX(sz_h, sz_v));
+	if (!buf)
+		return	-1;
+	memset(buf, 0, MAX(sz_h, sz_v));
+	if (ih)
+		dilate_rows(m, ih, buf);
+	if (iv)
+		dilate_cols(m, iv, buf);
+	pool_put_buf(buf);
+	return	0;
+}
+
+/*
+ * van Herk/Gil-Werman:  the (padded) line is cut in blocks of k = 2i+1 pixels;
+ * g[] is the running max from the start of each block, and r[] the running
+ * max from its end.  Any window of k pixels is the end of one block and the
+ * start of the next (or one whole block), so its max is max(r[x], g[x+k-1]).
+ * The padding is 0, which is neutral for a dilation.
+ */
+static
+void	dilate_rows	(const struct Morph_Img *restrict m, ptrdiff_t i,
+			 uint8_t *restrict buf)
+{
+	uint8_t		*line, *g, *r, *row;
+	ptrdiff_t	k, len;
+
+	k	= 2 * i + 1;
+	len	= morph_len(m->w, i);
+	memset(buf, 0, len);
+	line	= buf;
+	g	= buf + len;
+	r	= buf + 2 * len;
+
+	for (ptrdiff_t y = 0; y < m->h; y++) {
+		row	= m->data + y * m->step;
+		memcpy(line + i, row, m->w);
+		for (ptrdiff_t b = 0; b < len; b += k) {
+			g[b]	= line[b];
+			for (ptrdiff_t j = b + 1; j < b + k; j++)
+				g[j]	= MAX(g[j - 1], line[j]);
+			r[b + k - 1]	= line[b + k - 1];
+			for (ptrdiff_t j = b + k - 2; j >= b; j--)
+				r[j]	= MAX(r[j + 1], line[j]);
+		}
+		for (ptrdiff_t x = 0; x < m->w; x++)
+			row[x]	= MAX(r[x], g[x + k - 1]);
+	}
+}
+
+/*
+ * Same as dilate_rows(), with whole rows as the elements, so that the inner
+ * loops run along a row (and vectorize).
+ */
+static
+void	dilate_cols	(const struct Morph_Img *restrict m, ptrdiff_t i,
+			 uint8_t *restrict buf)
+{
+	uint8_t		*zero, *g, *r;
+	const uint8_t	*in;
+	ptrdiff_t	k, len, w;
+
+	k	= 2 * i + 1;
+	len	= morph_len(m->h, i);
+	w	= m->w;
+	memset(buf, 0, w);
+	zero	= buf;
+	g	= buf + w;
+	r	= buf + (len + 1) * w;
+
+#define in_row(j)	(((j) < i || (j) >= i + m->h) ?			\
+			zero : m->data + ((j) - i) * m->step)
+	for (ptrdiff_t b = 0; b < len; b += k) {
+		memcpy(g + b * w, in_row(b), w);
+		for (ptrdiff_t j = b + 1; j < b + k; j++) {
+			in	= in_row(j);
+			for (ptrdiff_t x = 0; x < w; x++)
+				g[j * w + x]	= MAX(g[(j - 1) * w + x], in[x]);
+		}
+		memcpy(r + (b + k - 1) * w, in_row(b + k - 1), w);
+		for (ptrdiff_t j = b + k - 2; j >= b; j--) {
+			in	= in_row(j);
+			for (ptrdiff_t x = 0; x < w; x++)
+				r[j * w + x]	= MAX(r[(j + 1) * w + x], in[x]);
+		}
+	}
+#undef in_row
+	for (ptrdiff_t y = 0; y < m->h; y++) {
+		for (ptrdiff_t x = 0; x < w; x++) {
+			m->data[y * m->step + x] = MAX(r[y * w + x],
+						g[(y + k - 1) * w + x]);
+		}
+	}
+}
+
+/* erode(img) == ~dilate(~img);  the 0 padding becomes 255, still neutral */
+static
+int	erode		(const struct Morph_Img *m, ptrdiff_t ih, ptrdiff_t iv)
+{
+	int	status;
+
+	invert(m);
+	status	= dilate(m, ih, iv);
+	invert(m);
+	return	status;
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
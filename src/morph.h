@@ -0,0 +1,67 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* morph.h */
+
+
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * Drop-in replacements for the morphology of libalx-cv, on 8-bit single
+ * channel images.  A size of i means a (2i+1)-pixel kernel (rectangular, or a
+ * line for the _h/_v variants), the same as i iterations of the 3-pixel one.
+ * The van Herk/Gil-Werman algorithm makes the cost per pixel constant (3
+ * comparisons per pass), whatever the size of the kernel.  Other images
+ * (or a failure to allocate) fall back to libalx.
+ */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <stddef.h>
+
+#include <libalx/extra/cv/cv.h>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+void	morph_dilate		(img_s *img, ptrdiff_t i);
+void	morph_erode		(img_s *img, ptrdiff_t i);
+void	morph_dilate_h		(img_s *img, ptrdiff_t i);
+void	morph_dilate_v		(img_s *img, ptrdiff_t i);
+void	morph_dilate_erode	(img_s *img, ptrdiff_t i);
+void	morph_erode_dilate	(img_s *img, ptrdiff_t i);
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,277 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "pool.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "ccl.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+/* The size is kept in front of the memory handed out */
+struct	Pool_Buf {
+	size_t		size;
+	max_align_t	data[];
+};
+
+/* Every array is a stack of free objects */
+struct	Pool {
+	img_s		*img[POOL_IMGS];
+	ptrdiff_t	nimgs;
+	conts_s		*conts[POOL_CONTS];
+	ptrdiff_t	nconts;
+	rect_s		*rect[POOL_RECTS];
+	ptrdiff_t	nrects;
+	rect_rot_s	*rect_rot[POOL_RECT_ROTS];
+	ptrdiff_t	nrect_rots;
+	struct Ccl	*ccl[POOL_CCLS];
+	ptrdiff_t	nccls;
+	struct Pool_Buf	*buf[POOL_BUFS];
+	ptrdiff_t	nbufs;
+};
+
+
+/******************************************************************************
+ ******* variables ************************************************************
+ ******************************************************************************/
+static _Thread_local struct Pool	*bound;
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+ptrdiff_t	buf_fit		(const struct Pool *pool, size_t size);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+int	init_pool	(struct Pool **pool)
+{
+
+	*pool	= calloc(1, sizeof(**pool));
+	if (!*pool)
+		return	-1;
+	return	0;
+}
+
+void	deinit_pool	(struct Pool *pool)
+{
+
+	if (!pool)
+		return;
+	if (bound == pool)
+		bound	= NULL;
+	for (ptrdiff_t i = 0; i < pool->nbufs; i++)
+		free(pool->buf[i]);
+	for (ptrdiff_t i = 0; i < pool->nccls; i++)
+		deinit_ccl(pool->ccl[i]);
+	for (ptrdiff_t i = 0; i < pool->nrect_rots; i++)
+		alx_cv_deinit_rect_rot(pool->rect_rot[i]);
+	for (ptrdiff_t i = 0; i < pool->nrects; i++)
+		alx_cv_deinit_rect(pool->rect[i]);
+	for (ptrdiff_t i = 0; i < pool->nconts; i++)
+		alx_cv_deinit_conts(pool->conts[i]);
+	for (ptrdiff_t i = 0; i < pool->nimgs; i++)
+		alx_cv_deinit_img(pool->img[i]);
+	free(pool);
+}
+
+/* Use pool (may be NULL) in this thread;  returns the previous one */
+struct Pool *pool_bind	(struct Pool *pool)
+{
+	struct Pool	*prev;
+
+	prev	= bound;
+	bound	= pool;
+	return	prev;
+}
+
+int	pool_get_img	(img_s **img)
+{
+
+	if (bound && bound->nimgs) {
+		*img	= bound->img[--bound->nimgs];
+		return	0;
+	}
+	return	alx_cv_init_img(img);
+}
+
+void	pool_put_img	(img_s *img)
+{
+
+	if (bound && bound->nimgs < ARRAY_SSIZE(bound->img)) {
+		bound->img[bound->nimgs++]	= img;
+		return;
+	}
+	alx_cv_deinit_img(img);
+}
+
+int	pool_get_conts	(conts_s **conts)
+{
+
+	if (bound && bound->nconts) {
+		*conts	= bound->conts[--bound->nconts];
+		return	0;
+	}
+	return	alx_cv_init_conts(conts);
+}
+
+void	pool_put_conts	(conts_s *conts)
+{
+
+	if (bound && bound->nconts < ARRAY_SSIZE(bound->conts)) {
+		bound->conts[bound->nconts++]	= conts;
+		return;
+	}
+	alx_cv_deinit_conts(conts);
+}
+
+int	pool_get_rect	(rect_s **rect)
+{
+
+	if (bound && bound->nrects) {
+		*rect	= bound->rect[--bound->nrects];
+		return	0;
+	}
+	return	alx_cv_init_rect(rect);
+}
+
+void	pool_put_rect	(rect_s *rect)
+{
+
+	if (bound && bound->nrects < ARRAY_SSIZE(bound->rect)) {
+		bound->rect[bound->nrects++]	= rect;
+		return;
+	}
+	alx_cv_deinit_rect(rect);
+}
+
+int	pool_get_rect_rot(rect_rot_s **rect_rot)
+{
+
+	if (bound && bound->nrect_rots) {
+		*rect_rot	= bound->rect_rot[--bound->nrect_rots];
+		return	0;
+	}
+	return	alx_cv_init_rect_rot(rect_rot);
+}
+
+void	pool_put_rect_rot(rect_rot_s *rect_rot)
+{
+
+	if (bound && bound->nrect_rots < ARRAY_SSIZE(bound->rect_rot)) {
+		bound->rect_rot[bound->nrect_rots++]	= rect_rot;
+		return;
+	}
+	alx_cv_deinit_rect_rot(rect_rot);
+}
+
+/* The buffers of a labeling are kept, and grown only when needed */
+int	pool_get_ccl	(struct Ccl **ccl)
+{
+
+	if (bound && bound->nccls) {
+		*ccl	= bound->ccl[--bound->nccls];
+		return	0;
+	}
+	return	init_ccl(ccl);
+}
+
+void	pool_put_ccl	(struct Ccl *ccl)
+{
+
+	if (bound && bound->nccls < ARRAY_SSIZE(bound->ccl)) {
+		bound->ccl[bound->nccls++]	= ccl;
+		return;
+	}
+	deinit_ccl(ccl);
+}
+
+/*
+ * Uninitialized memory of at least size bytes (aligned like malloc(3)), or
+ * NULL.  The smallest free buffer that is large enough is used;  if none
+ * is, the largest one is replaced by a new one of this size.
+ */
+void	*pool_get_buf	(size_t size)
+{
+	struct Pool_Buf	*b;
+	ptrdiff_t	i;
+
+	b	= NULL;
+	if (bound && bound->nbufs) {
+		i	= buf_fit(bound, size);
+		b	= bound->buf[i];
+		bound->buf[i]	= bound->buf[--bound->nbufs];
+	}
+	if (!b || b->size < size) {
+		free(b);
+		b	= malloc(sizeof(*b) + size);
+		if (!b)
+			return	NULL;
+		b->size	= size;
+	}
+	return	b->data;
+}
+
+void	pool_put_buf	(void *buf)
+{
+	struct Pool_Buf	*b;
+
+	if (!buf)
+		return;
+	b	= (struct Pool_Buf *)((char *)buf - offsetof(struct Pool_Buf, data));
+	if (bound && bound->nbufs < ARRAY_SSIZE(bound->buf)) {
+		bound->buf[bound->nbufs++]	= b;
+		return;
+	}
+	free(b);
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+/* The smallest buffer of at least size bytes, or else the largest one */
+static
+ptrdiff_t	buf_fit		(const struct Pool *pool, size_t size)
+{
+	ptrdiff_t	fit, max;
+	size_t		s;
+
+	fit	= -1;
+	max	= 0;
+	for (ptrdiff_t i = 0; i < pool->nbufs; i++) {
+		s	= pool->buf[i]->size;
+		if (s >= size && (fit < 0 || s < pool->buf[fit]->size))
+			fit	= i;
+		if (s > pool->buf[max]->size)
+			max	= i;
+	}
+	return	fit >= 0 ? fit : max;
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,94 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* pool.h */
+
+
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * Scratch objects (images, contours, rectangles, labelings, and plain
+ * buffers) that the stages take and give back, instead of creating and
+ * destroying their own at every call.
+ *
+ * A pool belongs to a context, and read_buf() binds it to the calling
+ * thread for the duration of the read (pool_bind()).  pool_get_*() take an
+ * object from the pool of the thread, and pool_put_*() give it back, so
+ * that from the second image on the objects (and their memory) are reused.
+ * With no pool bound (e.g., while loading the templates), or when the pool
+ * is empty or full, they fall back to creating and destroying the object,
+ * so they can be used anywhere.
+ *
+ * The images keep their pixels:  OpenCV only reallocates them when they are
+ * written with a different size.
+ */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <stddef.h>
+
+#include <libalx/extra/cv/cv.h>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+/* Objects of every kind kept by a pool;  any more are destroyed */
+#define POOL_IMGS	(16)
+#define POOL_CONTS	(4)
+#define POOL_RECTS	(8)
+#define POOL_RECT_ROTS	(4)
+#define POOL_CCLS	(4)
+#define POOL_BUFS	(8)
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+struct	Ccl;
+struct	Pool;
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+int	init_pool	(struct Pool **pool);
+void	deinit_pool	(struct Pool *pool);
+struct Pool *pool_bind	(struct Pool *pool);
+
+int	pool_get_img	(img_s **img);
+void	pool_put_img	(img_s *img);
+int	pool_get_conts	(conts_s **conts);
+void	pool_put_conts	(conts_s *conts);
+int	pool_get_rect	(rect_s **rect);
+void	pool_put_rect	(rect_s *rect);
+int	pool_get_rect_rot(rect_rot_s **rect_rot);
+void	pool_put_rect_rot(rect_rot_s *rect_rot);
+int	pool_get_ccl	(struct Ccl **ccl);
+void	pool_put_ccl	(struct Ccl *ccl);
+void	*pool_get_buf	(size_t size);
+void	pool_put_buf	(void *buf);
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,298 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#define _GNU_SOURCE
+#include "prof.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+
+#include "ctx.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+/* total, decode, 5 stages of the label, and 5 of every symbol */
+#define PROF_MAX_RECS	(7 + 7 * MAX_SYMBOLS)
+#define PROF_MAX_DEPTH	(4)
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+struct	Prof {
+	int			mode;
+	int			fd[PROF_HW_QTY];
+	bool			hw;
+	struct Prof_Snap	stack[PROF_MAX_DEPTH];
+	int			depth;
+	struct Prof_Rec		recs[PROF_MAX_RECS];
+	ptrdiff_t		n;
+};
+
+/* PERF_FORMAT_GROUP */
+struct	Prof_Group {
+	uint64_t	nr;
+	uint64_t	val[PROF_HW_QTY];
+};
+
+
+/******************************************************************************
+ ******* variables ************************************************************
+ ******************************************************************************/
+const char *const	prof_stage_names[PROF_STAGES]	= {
+	[PROF_TOTAL]			= "total",
+	[PROF_DECODE]			= "decode",
+	[PROF_FIND_LABEL]		= "find_label",
+	[PROF_FIND_SYMBOLS_VERTICALLY]	= "find_symbols_vertically",
+	[PROF_FIND_SYMBOLS_HORIZONTALLY] = "find_symbols_horizontally",
+	[PROF_ALIGN_SYMBOLS]		= "align_symbols",
+	[PROF_EXTRACT_SYMBOLS]		= "extract_symbols",
+	[PROF_CLEAN_SYMBOL]		= "clean_symbol",
+	[PROF_SPLIT_SYMBOL]		= "split_symbol",
+	[PROF_MATCH_T_BASE]		= "match_t_base",
+	[PROF_SYMBOL_INNER]		= "symbol_inner",
+	[PROF_MATCH_T_INNER]		= "match_t_inner",
+	[PROF_SYMBOL_OUTER]		= "symbol_outer",
+	[PROF_MATCH_T_OUTER]		= "match_t_outer",
+};
+
+static const uint64_t	hw_config[PROF_HW_QTY]	= {
+	[PROF_HW_CYCLES]	= PERF_COUNT_HW_CPU_CYCLES,
+	[PROF_HW_INSTRUCTIONS]	= PERF_COUNT_HW_INSTRUCTIONS,
+	[PROF_HW_CACHE_MISSES]	= PERF_COUNT_HW_CACHE_MISSES,
+};
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+int	hw_open		(struct Prof *prof);
+static
+void	hw_close	(struct Prof *prof);
+static
+void	snap		(struct Prof *restrict prof,
+			 struct Prof_Snap *restrict s);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+int	init_prof	(struct Prof **prof, int mode)
+{
+	struct Prof	*p;
+
+	*prof	= NULL;
+	if (mode == PROF_OFF)
+		return	0;
+	p	= calloc(1, sizeof(*p));
+	if (!p)
+		return	-1;
+	p->mode	= mode;
+	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(p->fd); i++)
+		p->fd[i]	= -1;
+	/* Without the counters (e.g., perf_event_paranoid), time only */
+	if (mode == PROF_HW && hw_open(p))
+		fputs("[warning]	profile: no hardware counters\n", stderr);
+
+	*prof	= p;
+	return	0;
+}
+
+void	deinit_prof	(struct Prof *prof)
+{
+
+	if (!prof)
+		return;
+	hw_close(prof);
+	free(prof);
+}
+
+void	prof_start	(struct Prof *prof)
+{
+
+	if (!prof)
+		return;
+	if (prof->depth < PROF_MAX_DEPTH)
+		snap(prof, &prof->stack[prof->depth]);
+	prof->depth++;
+}
+
+void	prof_stop	(struct Prof *prof, int stage, ptrdiff_t sym)
+{
+	struct Prof_Snap	now;
+	struct Prof_Rec		*rec;
+	const struct Prof_Snap	*s;
+
+	if (!prof)
+		return;
+	snap(prof, &now);
+	prof->depth--;
+	if (prof->depth >= PROF_MAX_DEPTH || prof->n >= PROF_MAX_RECS)
+		return;
+
+	s	= &prof->stack[prof->depth];
+	rec	= &prof->recs[prof->n++];
+	rec->stage	= stage;
+	rec->sym	= sym;
+	rec->d.ns	= now.ns - s->ns;
+	for (ptrdiff_t i = 0; i < PROF_HW_QTY; i++)
+		rec->d.hw[i]	= prof->hw ? now.hw[i] - s->hw[i] : -1;
+}
+
+/* The records of the last image (since prof_clear()) */
+const struct Prof_Rec *prof_recs(const struct Prof *restrict prof,
+			 ptrdiff_t *restrict n)
+{
+
+	*n	= prof ? prof->n : 0;
+	return	prof ? prof->recs : NULL;
+}
+
+/* The mode prof was initialized with (PROF_OFF if NULL) */
+int	prof_mode	(const struct Prof *prof)
+{
+
+	return	prof ? prof->mode : PROF_OFF;
+}
+
+/*
+ * Move the records of src (e.g., of another thread, which has its own
+ * counters) to the end of dst.
+ */
+void	prof_merge	(struct Prof *restrict dst, struct Prof *restrict src)
+{
+
+	if (!dst || !src)
+		return;
+	for (ptrdiff_t i = 0; i < src->n && dst->n < PROF_MAX_RECS; i++)
+		dst->recs[dst->n++]	= src->recs[i];
+	prof_clear(src);
+}
+
+void	prof_clear	(struct Prof *prof)
+{
+
+	if (!prof)
+		return;
+	prof->n		= 0;
+	prof->depth	= 0;
+}
+
+/*
+ * Print (and forget) the records of the last image, one per line:
+ *	prof <name> <stage> <symbol> <ns> <cycles> <instructions> <cache misses>
+ * separated by tabs;  the symbol is -1 for stages of the whole image, and
+ * the counters are -1 if they aren't available.  The lines of one image are
+ * printed together, even if other threads print to the same stream.
+ */
+void	prof_fprint	(FILE *restrict stream, struct Prof *restrict prof,
+			 const char *restrict name)
+{
+	const struct Prof_Rec	*rec;
+
+	if (!prof)
+		return;
+	flockfile(stream);
+	for (ptrdiff_t i = 0; i < prof->n; i++) {
+		rec	= &prof->recs[i];
+		fprintf(stream, "prof\t%s\t%s\t%ti\t%"PRIi64,
+				name, prof_stage_names[rec->stage], rec->sym,
+				rec->d.ns);
+		for (ptrdiff_t j = 0; j < PROF_HW_QTY; j++)
+			fprintf(stream, "\t%"PRIi64, rec->d.hw[j]);
+		fputc('\n', stream);
+	}
+	funlockfile(stream);
+	prof_clear(prof);
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+/* One group, read at once, counting this thread in user space */
+static
+int	hw_open		(struct Prof *prof)
+{
+	struct perf_event_attr	attr;
+	int			leader;
+
+	leader	= -1;
+	for (ptrdiff_t i = 0; i < PROF_HW_QTY; i++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.size		= sizeof(attr);
+		attr.type		= PERF_TYPE_HARDWARE;
+		attr.config		= hw_config[i];
+		attr.read_format	= PERF_FORMAT_GROUP;
+		attr.exclude_kernel	= 1;
+		attr.exclude_hv		= 1;
+		prof->fd[i]	= syscall(SYS_perf_event_open, &attr, 0, -1,
+						leader, PERF_FLAG_FD_CLOEXEC);
+		if (prof->fd[i] < 0)
+			goto err;
+		if (leader < 0)
+			leader	= prof->fd[i];
+	}
+
+	prof->hw	= true;
+	return	0;
+err:
+	hw_close(prof);
+	return	-1;
+}
+
+static
+void	hw_close	(struct Prof *prof)
+{
+
+	for (ptrdiff_t i = PROF_HW_QTY - 1; i >= 0; i--) {
+		if (prof->fd[i] >= 0)
+			close(prof->fd[i]);
+		prof->fd[i]	= -1;
+	}
+	prof->hw	= false;
+}
+
+static
+void	snap		(struct Prof *restrict prof,
+			 struct Prof_Snap *restrict s)
+{
+	struct timespec		ts;
+	struct Prof_Group	g;
+
+	if (prof->hw) {
+		if (read(prof->fd[0], &g, sizeof(g)) != sizeof(g))
+			memset(&g, 0, sizeof(g));
+		for (ptrdiff_t i = 0; i < PROF_HW_QTY; i++)
+			s->hw[i]	= g.val[i];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	s->ns	= ts.tv_sec * INT64_C(1000000000) + ts.tv_nsec;
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
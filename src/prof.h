@@ -0,0 +1,135 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* prof.h */
+
+
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * Per-stage profile of the reading of one image:  wall time and, with
+ * PROF_HW, the cycles, instructions and cache misses of the calling thread
+ * (perf_event_open(2)).  A context profiles only the thread that uses it.
+ * All the functions accept a NULL profile, which does nothing.
+ */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+/* Run call (which returns int) as stage (of symbol sym, or -1) */
+#define prof_stage(prof, stage, sym, call)	(			\
+{									\
+	int	prof_s_;						\
+									\
+	prof_start(prof);						\
+	prof_s_	= (call);						\
+	prof_stop(prof, stage, sym);					\
+									\
+	prof_s_;							\
+}									\
+)
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+enum	Prof_Mode {
+	PROF_OFF,
+	PROF_WALL,
+	PROF_HW
+};
+
+enum	Prof_Stage {
+	PROF_TOTAL,
+	PROF_DECODE,
+	PROF_FIND_LABEL,
+	PROF_FIND_SYMBOLS_VERTICALLY,
+	PROF_FIND_SYMBOLS_HORIZONTALLY,
+	PROF_ALIGN_SYMBOLS,
+	PROF_EXTRACT_SYMBOLS,
+	PROF_CLEAN_SYMBOL,
+	PROF_SPLIT_SYMBOL,
+	PROF_MATCH_T_BASE,
+	PROF_SYMBOL_INNER,
+	PROF_MATCH_T_INNER,
+	PROF_SYMBOL_OUTER,
+	PROF_MATCH_T_OUTER,
+
+	PROF_STAGES
+};
+
+
+enum	Prof_Hw {
+	PROF_HW_CYCLES,
+	PROF_HW_INSTRUCTIONS,
+	PROF_HW_CACHE_MISSES,
+
+	PROF_HW_QTY
+};
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+struct	Prof;
+
+struct	Prof_Snap {
+	int64_t		ns;
+	int64_t		hw[PROF_HW_QTY];
+};
+
+/* A stage, in the order it finished;  d holds the differences (-1 if n/a) */
+struct	Prof_Rec {
+	int			stage;
+	ptrdiff_t		sym;
+	struct Prof_Snap	d;
+};
+
+
+/******************************************************************************
+ ******* variables ************************************************************
+ ******************************************************************************/
+extern	const char *const	prof_stage_names[PROF_STAGES];
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+/* PROF_OFF sets *prof to NULL */
+int	init_prof	(struct Prof **prof, int mode);
+void	deinit_prof	(struct Prof *prof);
+void	prof_start	(struct Prof *prof);
+void	prof_stop	(struct Prof *prof, int stage, ptrdiff_t sym);
+const struct Prof_Rec *prof_recs(const struct Prof *restrict prof,
+			 ptrdiff_t *restrict n);
+int	prof_mode	(const struct Prof *prof);
+void	prof_merge	(struct Prof *restrict dst, struct Prof *restrict src);
+void	prof_clear	(struct Prof *prof);
+void	prof_fprint	(FILE *restrict stream, struct Prof *restrict prof,
+			 const char *restrict name);
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,294 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "reader.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/base/stdint.h>
+#include <libalx/base/stdio.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "cache.h"
+#include "ctx.h"
+#include "cvx.h"
+#include "dbg.h"
+#include "jpeg.h"
+#include "label.h"
+#include "pool.h"
+#include "prof.h"
+#include "symbols.h"
+#include "tasks.h"
+#include "templates/base.h"
+#include "templates/templates.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+/* The symbols of a label, read as independent tasks */
+struct	Sym_Tasks {
+	struct Ctx	*ctx;
+	uint32_t	*codes;
+	int		status[MAX_SYMBOLS];
+};
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+int	decode		(struct Ctx *restrict ctx, const void *restrict buf,
+			 size_t size);
+static
+void	read_symbol	(void *arg, ptrdiff_t i, struct Prof *prof);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+/*
+ * Run the whole pipeline on the image already decoded into ctx->img.
+ * Returns 0, or the (1-based) stage that failed.  Codes of the symbols read
+ * before a failure are kept in codes[0 .. *n).
+ *
+ * Once extracted, the symbols are independent, and are read in parallel if
+ * the context has tasks (not while debugging, which shows them in order).
+ */
+int	read_label	(struct Ctx *restrict ctx, uint32_t codes[MAX_SYMBOLS],
+			 ptrdiff_t *restrict n)
+{
+	struct Sym_Tasks	st;
+	struct Prof		*p;
+	int			status;
+
+	p	= ctx->prof;
+	*n	= 0;
+	status	= 1;
+	if (prof_stage(p, PROF_FIND_LABEL, -1, find_label(ctx)))
+		return	status;
+	status++;
+	if (prof_stage(p, PROF_FIND_SYMBOLS_VERTICALLY, -1,
+					find_symbols_vertically(ctx)))
+		return	status;
+	status++;
+	if (prof_stage(p, PROF_FIND_SYMBOLS_HORIZONTALLY, -1,
+					find_symbols_horizontally(ctx)))
+		return	status;
+	status++;
+	if (prof_stage(p, PROF_ALIGN_SYMBOLS, -1, align_symbols(ctx)))
+		return	status;
+	status++;
+	if (prof_stage(p, PROF_EXTRACT_SYMBOLS, -1, extract_symbols(ctx)))
+		return	status;
+	status++;
+	st.ctx		= ctx;
+	st.codes	= codes;
+	tasks_run(DBG ? NULL : ctx->tasks, &read_symbol, &st, ctx->nsyms, p);
+	for (ptrdiff_t i = 0; i < ctx->nsyms; i++) {
+		if (st.status[i])
+			return	status;
+		(*n)++;
+	}
+
+	return	0;
+}
+
+/*
+ * Decode an image and read its label.  Returns 0, or the exit status that
+ * main() would have had:  READ_STATUS_IMG if the image can't be decoded, or
+ * READ_STATUS_IMG plus the return value of read_label().
+ */
+int	read_file	(struct Ctx *restrict ctx, const char *restrict fname,
+			 uint32_t codes[MAX_SYMBOLS], ptrdiff_t *restrict n)
+{
+	struct stat	st;
+	void		*buf;
+	int		fd;
+	int		status;
+
+	*n	= 0;
+	fd	= open(fname, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return	READ_STATUS_IMG;
+	status	= READ_STATUS_IMG;
+	if (fstat(fd, &st) || !st.st_size)
+		goto err;
+	buf	= mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (buf == MAP_FAILED)
+		goto err;
+	status	= read_buf(ctx, buf, st.st_size, codes, n);
+	munmap(buf, st.st_size);
+err:	close(fd);
+	return	status;
+}
+
+/*
+ * Like read_file(), from the encoded image in buf.  If the context has a
+ * cache, images already read come from it, without being decoded.
+ */
+int	read_buf	(struct Ctx *restrict ctx, const void *restrict buf,
+			 size_t size,
+			 uint32_t codes[MAX_SYMBOLS], ptrdiff_t *restrict n)
+{
+	struct Pool	*prev;
+	int		status;
+
+	*n	= 0;
+	prev	= pool_bind(ctx->pool);
+	dbg_begin();
+	prof_start(ctx->prof);
+	status	= cache_get(ctx->cache, buf, size, codes, n);
+	if (status >= 0)
+		goto out;
+	status	= READ_STATUS_IMG;
+	if (prof_stage(ctx->prof, PROF_DECODE, -1, decode(ctx, buf, size)))
+		goto err;
+	status	= read_label(ctx, codes, n);
+	if (status)
+		status	+= READ_STATUS_IMG;
+	cache_put(ctx->cache, status, codes, *n);
+err:	ctx->buf	= NULL;
+	ctx->size	= 0;
+out:	prof_stop(ctx->prof, PROF_TOTAL, -1);
+	dbg_end();
+	pool_bind(prev);
+	return	status;
+}
+
+/* Read the whole stream (e.g., stdin) into memory and decode it from there */
+int	read_stream	(struct Ctx *restrict ctx, FILE *restrict stream,
+			 uint32_t codes[MAX_SYMBOLS], ptrdiff_t *restrict n)
+{
+	unsigned char	*buf, *tmp;
+	size_t		size, len;
+	int		status;
+
+	*n	= 0;
+	buf	= NULL;
+	size	= 0;
+	len	= 0;
+	status	= READ_STATUS_IMG;
+	do {
+		if (len == size) {
+			size	= size ? size * 2 : 1 << 20;
+			tmp	= realloc(buf, size);
+			if (!tmp)
+				goto err;
+			buf	= tmp;
+		}
+		len	+= fread(buf + len, 1, size - len, stream);
+	} while (len == size);
+	if (ferror(stream))
+		goto err;
+
+	status	= read_buf(ctx, buf, len, codes, n);
+err:	free(buf);
+	return	status;
+}
+
+void	print_result	(FILE *restrict stream, const char *restrict name,
+			 int status, const uint32_t *restrict codes,
+			 ptrdiff_t n)
+{
+
+	fprintf(stream, "%s\t%i\n", name, status);
+	for (ptrdiff_t i = 0; i < n; i++)
+		fprint_code(stream, codes[i]);
+	fputc('\n', stream);
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+/*
+ * A JPEG is decoded only at the reduced scale used by find_label(), which
+ * later decodes the label alone at full resolution;  anything else
+ * (including JPEGs that have to be rotated or flipped as their EXIF says) is
+ * decoded in full by OpenCV and then reduced.
+ */
+static
+int	decode		(struct Ctx *restrict ctx, const void *restrict buf,
+			 size_t size)
+{
+	ptrdiff_t	w, h;
+
+	ctx->buf	= buf;
+	ctx->size	= size;
+	ctx->crop	= is_jpeg(buf, size);
+	if (ctx->crop && !decode_jpeg_scaled(ctx->lbl, buf, size,
+						LABEL_MIN_PX, &ctx->scale))
+		return	0;
+
+	ctx->crop	= false;
+	if (cvx_decode(ctx->img, buf, size))
+		return	-1;
+	alx_cv_extract_imgdata(ctx->img, NULL, &w, &h, NULL, NULL, NULL);
+	ctx->scale	= jpeg_scale(w, h, LABEL_MIN_PX);
+	return	cvx_downscale(ctx->lbl, ctx->img, ctx->scale);
+}
+
+/* Symbol i of arg (struct Sym_Tasks);  profiled in p */
+static
+void	read_symbol	(void *arg, ptrdiff_t i, struct Prof *p)
+{
+	struct Sym_Tasks	*st;
+	struct Ctx		*ctx;
+	uint32_t		*code;
+
+	st	= arg;
+	ctx	= st->ctx;
+	code	= &st->codes[i];
+	*code	= 0;
+	st->status[i]	= -1;
+	if (prof_stage(p, PROF_CLEAN_SYMBOL, i, clean_symbol(ctx, i)))
+		return;
+	if (prof_stage(p, PROF_SPLIT_SYMBOL, i, split_symbol(ctx, i)))
+		return;
+	if (prof_stage(p, PROF_MATCH_T_BASE, i, match_t_base(ctx, i, code)))
+		return;
+	/*
+	 * The inner part isn't split if the grammar of the base ignores it,
+	 * and neither part is if the base is crossed out.
+	 */
+	if (t_reads_inner(*code) &&
+	    prof_stage(p, PROF_SYMBOL_INNER, i, symbol_inner(ctx, i)))
+		return;
+	if (prof_stage(p, PROF_MATCH_T_INNER, i,
+					match_t_inner(ctx, i, code)) < 0)
+		return;
+	if (BIT_READ(*code, CODE_Y_N_POS) &&
+	    prof_stage(p, PROF_SYMBOL_OUTER, i, symbol_outer(ctx, i)))
+		return;
+	if (prof_stage(p, PROF_MATCH_T_OUTER, i,
+					match_t_outer(ctx, i, code)) < 0)
+		return;
+	st->status[i]	= 0;
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,66 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* reader.h */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <libalx/extra/cv/cv.h>
+
+#include "ctx.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+/* Status of the read_*() functions when the image can't be decoded */
+#define READ_STATUS_IMG	(4)
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+int	read_label	(struct Ctx *restrict ctx, uint32_t codes[MAX_SYMBOLS],
+			 ptrdiff_t *restrict n);
+int	read_file	(struct Ctx *restrict ctx, const char *restrict fname,
+			 uint32_t codes[MAX_SYMBOLS], ptrdiff_t *restrict n);
+int	read_buf	(struct Ctx *restrict ctx, const void *restrict buf,
+			 size_t size,
+			 uint32_t codes[MAX_SYMBOLS], ptrdiff_t *restrict n);
+int	read_stream	(struct Ctx *restrict ctx, FILE *restrict stream,
+			 uint32_t codes[MAX_SYMBOLS], ptrdiff_t *restrict n);
+void	print_result	(FILE *restrict stream, const char *restrict name,
+			 int status, const uint32_t *restrict codes,
+			 ptrdiff_t n);
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
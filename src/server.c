@@ -0,0 +1,256 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#define _GNU_SOURCE
+#include "server.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/base/errno.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "ctx.h"
+#include "prof.h"
+#include "reader.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* variables ************************************************************
+ ******************************************************************************/
+static volatile sig_atomic_t	stop;
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+int	set_signals	(void);
+static
+void	sig_stop	(int sig);
+static
+void	serve_req	(int fd, struct Ctx *restrict ctx);
+static
+int	read_req	(FILE *restrict in, char **restrict name,
+			 void **restrict buf, size_t *restrict size);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+/*
+ * Protocol (one request per connection):
+ *	request:	"path <fname>\n"
+ *		or	"data <size>\n" followed by <size> bytes of an image
+ *	response:	the same record as batch mode (see print_result()).
+ */
+int	serve		(const char *restrict path, struct Ctx *restrict ctx)
+{
+	struct sockaddr_un	addr;
+	int			sfd, cfd;
+	int			status;
+
+	status	= -1;
+	if (strlen(path) >= sizeof(addr.sun_path))
+		return	status;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family	= AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	status--;
+	if (set_signals())
+		return	status;
+	sfd	= socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (sfd < 0)
+		return	status;
+	status--;
+	unlink(path);
+	if (bind(sfd, (struct sockaddr *)&addr, sizeof(addr)))
+		goto err0;
+	status--;
+	if (listen(sfd, SOMAXCONN))
+		goto err;
+
+	while (!stop) {
+		cfd	= accept4(sfd, NULL, NULL, SOCK_CLOEXEC);
+		if (cfd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			goto err;
+		}
+		serve_req(cfd, ctx);
+	}
+
+	status	= 0;
+err:	unlink(path);
+err0:	close(sfd);
+	return	status;
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+static
+int	set_signals	(void)
+{
+	struct sigaction	sa;
+
+	memset(&sa, 0, sizeof(sa));
+	sigemptyset(&sa.sa_mask);
+	sa.sa_handler	= &sig_stop;
+	/* No SA_RESTART:  accept() has to return to see the flag */
+	if (sigaction(SIGINT, &sa, NULL))
+		return	-1;
+	if (sigaction(SIGTERM, &sa, NULL))
+		return	-1;
+	sa.sa_handler	= SIG_IGN;
+	if (sigaction(SIGPIPE, &sa, NULL))
+		return	-1;
+	return	0;
+}
+
+static
+void	sig_stop	(int sig)
+{
+
+	(void)sig;
+	stop	= 1;
+}
+
+static
+void	serve_req	(int fd, struct Ctx *restrict ctx)
+{
+	struct timeval	tv;
+	FILE		*in, *out;
+	char		*name;
+	void		*buf;
+	size_t		size;
+	uint32_t	codes[MAX_SYMBOLS];
+	ptrdiff_t	n;
+	int		ofd;
+	int		status;
+
+	tv.tv_sec	= SERVER_TIMEOUT;
+	tv.tv_usec	= 0;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+	in	= fdopen(fd, "r");
+	if (!in)
+		goto err0;
+	ofd	= dup(fd);
+	if (ofd < 0)
+		goto err1;
+	out	= fdopen(ofd, "w");
+	if (!out)
+		goto err2;
+
+	n	= 0;
+	name	= NULL;
+	buf	= NULL;
+	status	= read_req(in, &name, &buf, &size);
+	if (!status && buf)
+		status	= read_buf(ctx, buf, size, codes, &n);
+	else if (!status)
+		status	= read_file(ctx, name, codes, &n);
+	print_result(out, name ? name : "-", status, codes, n);
+	prof_fprint(stderr, ctx->prof, name ? name : "-");
+
+	free(buf);
+	free(name);
+	fclose(out);
+	fclose(in);
+	return;
+
+err2:	close(ofd);
+err1:	fclose(in);
+	return;
+err0:	close(fd);
+}
+
+/*
+ * Return values follow main()'s exit status:  1 for a malformed request,
+ * READ_STATUS_IMG if the image couldn't be received.
+ */
+static
+int	read_req	(FILE *restrict in, char **restrict name,
+			 void **restrict buf, size_t *restrict size)
+{
+	char		*line, *end;
+	size_t		sz;
+	ssize_t		len;
+	uintmax_t	n;
+	int		status;
+
+	line	= NULL;
+	sz	= 0;
+	status	= 1;
+	len	= getline(&line, &sz, in);
+	if (len < 0)
+		goto err;
+	if (len && line[len - 1] == '\n')
+		line[len - 1]	= '\0';
+
+	if (!strncmp(line, "path ", strlen("path "))) {
+		*name	= strdup(line + strlen("path "));
+		if (!*name)
+			goto err;
+	} else if (!strncmp(line, "data ", strlen("data "))) {
+		errno	= 0;
+		n	= strtoumax(line + strlen("data "), &end, 10);
+		if (errno || *end || !n || n > SERVER_MAX_IMG_SIZE)
+			goto err;
+		*buf	= malloc(n);
+		if (!*buf)
+			goto err;
+		status	= READ_STATUS_IMG;
+		if (fread(*buf, 1, n, in) != n)
+			goto err;
+		*size	= n;
+	} else {
+		goto err;
+	}
+
+	status	= 0;
+	free(line);
+	return	status;
+
+err:	free(line);
+	perrorx("[error]	request: %i\n", status);
+	return	status;
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
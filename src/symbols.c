@@ -13,6 +13,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <sys/param.h>
 
@@ -22,14 +23,19 @@
 #include <libalx/base/stdlib.h>
 #include <libalx/extra/cv/cv.h>
 
+#include "ccl.h"
+#include "ctx.h"
+#include "cvx.h"
 #include "dbg.h"
+#include "median.h"
+#include "morph.h"
+#include "pool.h"
 #include "templates/templates.h"
 
 
 /******************************************************************************
  ******* macro ****************************************************************
  ******************************************************************************/
-#define MAX_SYMBOLS	(5)
 
 
 /******************************************************************************
@@ -37,13 +43,6 @@
  ******************************************************************************/
 
 
-/******************************************************************************
- ******* variables ************************************************************
- ******************************************************************************/
-img_s		*symbols[MAX_SYMBOLS];
-ptrdiff_t	nsyms;
-
-
 /******************************************************************************
  ******* static prototypes ****************************************************
  ******************************************************************************/
@@ -52,48 +51,25 @@ ptrdiff_t	nsyms;
 /******************************************************************************
  ******* global functions *****************************************************
  ******************************************************************************/
-int	init_symbols	(void)
-{
-	ptrdiff_t	i;
-
-	for (i = 0; i < ARRAY_SSIZE(symbols); i++) {
-		if (alx_cv_init_img(&symbols[i]))
-			goto err0;
-	}
-	nsyms	= 0;
-
-	return	0;
-
-err0:	for (i--; i >= 0; i--)
-		alx_cv_deinit_img(symbols[i]);
-	return	-1;
-}
-
-void	deinit_symbols	(void)
-{
-
-	nsyms	= 0;
-	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(symbols); i++)
-		alx_cv_deinit_img(symbols[i]);
-}
-
-int	extract_symbols	(img_s *restrict img)
+int	extract_symbols	(struct Ctx *ctx)
 {
+	img_s		*img;
 	img_s		*tmp;
-	conts_s		*conts;
-	const cont_s	*cont;
+	struct Ccl	*ccl;
+	ptrdiff_t	syms[MAX_SYMBOLS];
 	rect_s		*rect;
 	ptrdiff_t	x, y, w, h;
 	ptrdiff_t	y_all, w_all, h_all;
 	int		status;
 
 	/* init */
+	img	= ctx->img;
 	status	= -1;
-	if (alx_cv_init_img(&tmp))
+	if (pool_get_img(&tmp))
 		return	status;
-	if (alx_cv_init_conts(&conts))
+	if (pool_get_ccl(&ccl))
 		goto err0;
-	if (alx_cv_init_rect(&rect))
+	if (pool_get_rect(&rect))
 		goto err1;
 
 	/* Find symbols */
@@ -101,18 +77,17 @@ int	extract_symbols	(img_s *restrict img)
 	alx_cv_extract_imgdata(img, NULL, &w, &h, NULL, NULL, NULL);
 	alx_cv_clone(tmp, img);					dbg_show(2, tmp);
 	alx_cv_normalize(tmp);					dbg_show(3, tmp);
-	alx_cv_smooth(tmp, ALX_CV_SMOOTH_MEDIAN, 3);		dbg_show(3, tmp);
+	median_blur(tmp, MEDIAN_NET, 3);			dbg_show(3, tmp);
 	alx_cv_adaptive_thr(tmp, ALX_CV_ADAPTIVE_THRESH_GAUSSIAN,
 			ALX_CV_THRESH_BINARY_INV, h / 2, 5);	dbg_show(3, tmp);
-	alx_cv_holes_fill(tmp);
-	alx_cv_erode_dilate(tmp, h / 15);			dbg_show(3, tmp);
-	alx_cv_dilate_erode(tmp, h / 15);			dbg_show(3, tmp);
-	alx_cv_contours(tmp, conts);
-	alx_cv_sort_conts_lr(conts);
-	if (alx_cv_extract_conts(conts, NULL, &nsyms))
+	ccl_holes_fill(tmp);
+	morph_erode_dilate(tmp, h / 15);			dbg_show(3, tmp);
+	morph_dilate_erode(tmp, h / 15);			dbg_show(3, tmp);
+	if (ccl_label(ccl, tmp))
 		goto err;
-	if (nsyms != 5) {
-		perrorx("[error]	%i symbols detected\n", (int)nsyms);
+	ctx->nsyms	= ccl_outer(ccl, syms, ARRAY_SSIZE(syms));
+	if (ctx->nsyms != MAX_SYMBOLS) {
+		perrorx("[error]	%i symbols detected\n", (int)ctx->nsyms);
 		goto err;
 	}
 
@@ -121,10 +96,8 @@ int	extract_symbols	(img_s *restrict img)
 	y_all	= PTRDIFF_MAX;
 	w_all	= 0;
 	h_all	= 0;
-	for (ptrdiff_t i = 0; i < nsyms; i++) {
-		if (alx_cv_extract_conts_cont(&cont, conts, i))
-			goto err;
-		alx_cv_bounding_rect(rect, cont);
+	for (ptrdiff_t i = 0; i < ctx->nsyms; i++) {
+		ccl_bounding_rect(rect, ccl, syms[i]);
 		alx_cv_extract_rect(rect, &x, &y, &w, &h);
 		if (w > w_all)
 			w_all	= w;
@@ -140,40 +113,40 @@ int	extract_symbols	(img_s *restrict img)
 	h_all	*= 1.2;
 	y_all	-= h_all / 2;
 	w_all	*= 1.4;
-	for (ptrdiff_t i = 0; i < nsyms; i++) {
-		alx_cv_clone(symbols[i], img);			dbg_show(3, symbols[i]);
-		if (alx_cv_extract_conts_cont(&cont, conts, i))
-			goto err;
-		alx_cv_bounding_rect(rect, cont);
+	for (ptrdiff_t i = 0; i < ctx->nsyms; i++) {
+		cvx_view(ctx->sym[i], img);
+		ccl_bounding_rect(rect, ccl, syms[i]);
 		alx_cv_extract_rect(rect, &x, NULL, &w, NULL);
 		x	+= w / 2 - w_all / 2;
 		alx_cv_set_rect(rect, x, y_all, w_all, h_all);
-		alx_cv_roi_set(symbols[i], rect);		dbg_show(1, symbols[i]);
+		alx_cv_roi_set(ctx->sym[i], rect);		dbg_show(1, ctx->sym[i]);
 	}
 
 	/* deinit */
 	status	= 0;
-err:	alx_cv_deinit_rect(rect);
-err1:	alx_cv_deinit_conts(conts);
-err0:	alx_cv_deinit_img(tmp);
+err:	pool_put_rect(rect);
+err1:	pool_put_ccl(ccl);
+err0:	pool_put_img(tmp);
 	return	status;
 }
 
-int	clean_symbol	(img_s *img)
+int	clean_symbol	(struct Ctx *ctx, ptrdiff_t i)
 {
+	img_s		*img;
 	img_s		*mask, *bkgd;
-	conts_s		*conts;
+	struct Ccl	*ccl;
 	ptrdiff_t	w, h;
-	ptrdiff_t	i;
+	ptrdiff_t	j;
 	int		status;
 
 	/* init */
+	img	= ctx->sym[i];
 	status	= -1;
-	if (alx_cv_init_img(&mask))
+	if (pool_get_img(&mask))
 		return	status;
-	if (alx_cv_init_img(&bkgd))
+	if (pool_get_img(&bkgd))
 		goto err0;
-	if (alx_cv_init_conts(&conts))
+	if (pool_get_ccl(&ccl))
 		goto err1;
 
 	/* Find symbol */
@@ -181,14 +154,17 @@ int	clean_symbol	(img_s *img)
 	alx_cv_clone(mask, img);				dbg_show(2, mask);
 	alx_cv_threshold(mask, ALX_CV_THRESH_BINARY_INV, ALX_CV_THR_OTSU);
 								dbg_show(3, mask);
-	alx_cv_dilate(mask, 2);					dbg_show(3, mask);
-	alx_cv_holes_fill(mask);				dbg_show(3, mask);
-	alx_cv_contours(mask, conts);
+	morph_dilate(mask, 2);					dbg_show(3, mask);
+	ccl_holes_fill(mask);					dbg_show(3, mask);
+	if (ccl_label(ccl, mask))
+		goto err;
 	alx_cv_extract_imgdata(mask, NULL, &w, &h, NULL, NULL, NULL);
-	if (alx_cv_conts_closest(NULL, &i, conts, w / 2, h / 2, NULL))
+	j	= ccl_closest(ccl, w / 2, h / 2);
+	if (j < 0)
 		goto err;
-	alx_cv_contour_mask(mask, conts, i);			dbg_show(3, mask);
-	alx_cv_dilate(mask, 2);					dbg_show(3, mask);
+	if (ccl_mask(mask, ccl, j))
+		goto err;					dbg_show(3, mask);
+	morph_dilate(mask, 2);					dbg_show(3, mask);
 
 	/* Find BKGD */
 	alx_cv_clone(bkgd, img);				dbg_show(3, bkgd);
@@ -196,134 +172,199 @@ int	clean_symbol	(img_s *img)
 	alx_cv_invert(mask);					dbg_show(3, mask);
 	alx_cv_and_2ref(bkgd, mask);				dbg_show(3, bkgd);
 
-	/* Clean symbol */
+	/* Clean symbol (a view of the label until now) */
+	if (cvx_unshare(img))
+		goto err;
 	alx_cv_invert(mask);					dbg_show(3, mask);
 	alx_cv_and_2ref(img, mask);				dbg_show(3, img);
 	alx_cv_or_2ref(img, bkgd);				dbg_show(3, img);
 
 	/* Threshold */
 	alx_cv_normalize(img);					dbg_show(3, img);
-	alx_cv_smooth(img, ALX_CV_SMOOTH_MEDIAN, 3);		dbg_show(3, img);
+	median_blur(img, MEDIAN_NET, 3);			dbg_show(3, img);
 	w	= MIN(w, h);
 	alx_cv_adaptive_thr(img, ALX_CV_ADAPTIVE_THRESH_GAUSSIAN,
 			ALX_CV_THRESH_BINARY_INV, w / 2, 25);	dbg_show(1, img);
 
 	/* deinit */
 	status	= 0;
-err:	alx_cv_deinit_conts(conts);
-err1:	alx_cv_deinit_img(bkgd);
-err0:	alx_cv_deinit_img(mask);
+err:	pool_put_ccl(ccl);
+err1:	pool_put_img(bkgd);
+err0:	pool_put_img(mask);
 	return	status;
 }
 
-int	symbol_base	(const img_s *restrict sym, img_s *restrict base)
+/*
+ * Label the (clean) symbol i, and keep its base:  the largest blob, alone.
+ * The other parts are split from the same labeling, only if they are read
+ * (see symbol_inner() and symbol_outer()).
+ */
+int	split_symbol	(struct Ctx *ctx, ptrdiff_t i)
 {
-	img_s		*mask;
-	conts_s		*conts;
-	const cont_s	*cont;
-	rect_s		*rect;
-	ptrdiff_t	i;
-	int		status;
+	const img_s		*sym;
+	struct Sym_Parts	*part;
+	struct Ccl		*ccl;
+	rect_s			*rect;
+	bool			*on;
+	ptrdiff_t		base;
+	int			status;
 
 	/* init */
+	sym	= ctx->sym[i];
+	part	= &ctx->part[i];
+	ccl	= part->ccl;
+	part->base_comp	= -1;
+	part->has_inner	= false;
+	part->lines	= 0;
+	on	= NULL;
 	status	= -1;
-	if (alx_cv_init_img(&mask))
+	if (pool_get_rect(&rect))
 		return	status;
-	if (alx_cv_init_conts(&conts))
-		goto err0;
-	if (alx_cv_init_rect(&rect))
-		goto err1;
 
-	/* Find base */
+	/* Label the symbol */
 	status--;
-	alx_cv_clone(base, sym);				dbg_show(2, base);
-	alx_cv_holes_remove(base);				dbg_show(3, base);
-	alx_cv_clone(mask, base);				dbg_show(3, mask);
-	alx_cv_contours(mask, conts);
-	if (alx_cv_conts_largest_a(&cont, &i, conts))
+	if (ccl_label(ccl, sym))
+		goto err;
+	base	= ccl_largest_a(ccl);
+	if (base < 0)
 		goto err;
-	alx_cv_contour_mask(mask, conts, i);			dbg_show(3, mask);
-	alx_cv_and_2ref(base, mask);				dbg_show(3, base);
-	alx_cv_bounding_rect(rect, cont);
-	alx_cv_roi_set(base, rect);				dbg_show(1, base);
+	on	= pool_get_buf(sizeof(*on) * ccl->n);
+	if (!on)
+		goto err;
+	status--;
+
+	/* Base */
+	for (ptrdiff_t k = 0; k < ccl->n; k++)
+		on[k]	= k == base;
+	alx_cv_clone(part->base, sym);
+	if (ccl_select(part->base, ccl, on))
+		goto err;
+	ccl_bounding_rect(rect, ccl, base);
+	alx_cv_roi_set(part->base, rect);			dbg_show(1, part->base);
+	part->base_comp	= base;
 
 	/* deinit */
 	status	= 0;
-err:	alx_cv_deinit_rect(rect);
-err1:	alx_cv_deinit_conts(conts);
-err0:	alx_cv_deinit_img(mask);
+err:	pool_put_buf(on);
+	pool_put_rect(rect);
 	return	status;
 }
 
-int	symbol_inner	(const img_s *restrict sym, img_s *restrict in)
+/*
+ * What is inside the holes of the base (and of the other blobs) of symbol
+ * i, cropped to its largest blob (after a closing), if there is any.
+ */
+int	symbol_inner	(struct Ctx *ctx, ptrdiff_t i)
 {
-	img_s		*mask;
-	conts_s		*conts;
-	const cont_s	*cont;
-	rect_s		*rect;
-	int		status;
+	const img_s		*sym;
+	struct Sym_Parts	*part;
+	const struct Ccl	*lbl;
+	struct Ccl		*ccl;
+	img_s			*tmp;
+	rect_s			*rect;
+	bool			*on;
+	ptrdiff_t		k;
+	int			status;
 
 	/* init */
+	sym	= ctx->sym[i];
+	part	= &ctx->part[i];
+	lbl	= part->ccl;
+	part->has_inner	= false;
+	if (part->base_comp < 0)
+		return	-1;
 	status	= -1;
-	if (alx_cv_init_img(&mask))
+	if (pool_get_img(&tmp))
 		return	status;
-	if (alx_cv_init_conts(&conts))
+	if (pool_get_rect(&rect))
 		goto err0;
-	if (alx_cv_init_rect(&rect))
+	if (pool_get_ccl(&ccl))
 		goto err1;
+	on	= pool_get_buf(sizeof(*on) * lbl->n);
+	if (!on)
+		goto err2;
 
-	/* Find inner */
+	/* Inner */
 	status--;
-	alx_cv_clone(in, sym);					dbg_show(2, in);
-	alx_cv_holes_extract(in);				dbg_show(3, in);
-	alx_cv_clone(mask, in);					dbg_show(3, mask);
-	alx_cv_dilate_erode(mask, 10);				dbg_show(3, mask);
-	alx_cv_contours(mask, conts);
-	if (alx_cv_conts_largest_a(&cont, NULL, conts))
-		goto err;
-	alx_cv_bounding_rect(rect, cont);
-	alx_cv_roi_set(in, rect);				dbg_show(1, in);
+	for (k = 0; k < lbl->n; k++)
+		on[k]	= lbl->comp[k].fg && !ccl_is_outer(lbl, k);
+	alx_cv_clone(part->inner, sym);
+	if (ccl_select(part->inner, lbl, on))
+		goto err;					dbg_show(3, part->inner);
 
+	/* Crop inner */
+	status--;
+	alx_cv_clone(tmp, part->inner);				dbg_show(3, tmp);
+	morph_dilate_erode(tmp, 10);				dbg_show(3, tmp);
+	if (ccl_label(ccl, tmp))
+		goto err;
+	k	= ccl_largest_a(ccl);
+	if (k >= 0) {
+		ccl_bounding_rect(rect, ccl, k);
+		alx_cv_roi_set(part->inner, rect);		dbg_show(1, part->inner);
+		part->has_inner	= true;
+	}
 
 	/* deinit */
 	status	= 0;
-err:	alx_cv_deinit_rect(rect);
-err1:	alx_cv_deinit_conts(conts);
-err0:	alx_cv_deinit_img(mask);
+err:	pool_put_buf(on);
+err2:	pool_put_ccl(ccl);
+err1:	pool_put_rect(rect);
+err0:	pool_put_img(tmp);
 	return	status;
 }
 
-int	symbol_outer	(const img_s *restrict sym, img_s *restrict out)
+/*
+ * The lines of symbol i:  the blobs not enclosed by the base, with their
+ * holes filled;  only the count is kept, after an opening.
+ */
+int	symbol_outer	(struct Ctx *ctx, ptrdiff_t i)
 {
-	img_s		*mask;
-	conts_s		*conts;
-	ptrdiff_t	i;
-	int		status;
+	const img_s		*sym;
+	struct Sym_Parts	*part;
+	const struct Ccl	*lbl;
+	struct Ccl		*ccl;
+	img_s			*tmp;
+	bool			*on;
+	ptrdiff_t		o;
+	int			status;
 
 	/* init */
+	sym	= ctx->sym[i];
+	part	= &ctx->part[i];
+	lbl	= part->ccl;
+	part->lines	= 0;
+	if (part->base_comp < 0)
+		return	-1;
 	status	= -1;
-	if (alx_cv_init_img(&mask))
+	if (pool_get_img(&tmp))
 		return	status;
-	if (alx_cv_init_conts(&conts))
+	if (pool_get_ccl(&ccl))
 		goto err0;
+	on	= pool_get_buf(sizeof(*on) * lbl->n);
+	if (!on)
+		goto err1;
 
-	/* Find outer */
+	/* Outer */
+	status--;
+	for (ptrdiff_t k = 0; k < lbl->n; k++) {
+		o	= ccl_outer_of(lbl, k);
+		on[k]	= o >= 0 && o != part->base_comp;
+	}
+	alx_cv_clone(tmp, sym);
+	if (ccl_select(tmp, lbl, on))
+		goto err;					dbg_show(3, tmp);
+	morph_erode_dilate(tmp, 1);				dbg_show(1, tmp);
 	status--;
-	alx_cv_clone(out, sym);					dbg_show(2, out);
-	alx_cv_holes_fill(out);					dbg_show(3, mask);
-	alx_cv_clone(mask, out);				dbg_show(3, mask);
-	alx_cv_contours(mask, conts);
-	if (alx_cv_conts_largest_a(NULL, &i, conts))
+	if (ccl_label(ccl, tmp))
 		goto err;
-	alx_cv_contour_mask(mask, conts, i);			dbg_show(3, mask);
-	alx_cv_invert(mask);					dbg_show(3, mask);
-	alx_cv_and_2ref(out, mask);				dbg_show(3, out);
-	alx_cv_erode_dilate(out, 1);				dbg_show(1, out);
+	part->lines	= ccl_outer(ccl, NULL, 0);
 
 	/* deinit */
 	status	= 0;
-err:	alx_cv_deinit_conts(conts);
-err0:	alx_cv_deinit_img(mask);
+err:	pool_put_buf(on);
+err1:	pool_put_ccl(ccl);
+err0:	pool_put_img(tmp);
 	return	status;
 }
 
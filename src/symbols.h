@@ -17,6 +17,8 @@
 
 #include <libalx/extra/cv/cv.h>
 
+#include "ctx.h"
+
 
 /******************************************************************************
  ******* macros ***************************************************************
@@ -33,23 +35,14 @@
  ******************************************************************************/
 
 
-/******************************************************************************
- ******* variables ************************************************************
- ******************************************************************************/
-extern	img_s		*symbols[];
-extern	ptrdiff_t	nsyms;
-
-
 /******************************************************************************
  ******* prototypes ***********************************************************
  ******************************************************************************/
-int	init_symbols	(void);
-void	deinit_symbols	(void);
-int	extract_symbols	(img_s *restrict img);
-int	clean_symbol	(img_s *sym);
-int	symbol_base	(const img_s *restrict sym, img_s *restrict base);
-int	symbol_inner	(const img_s *restrict sym, img_s *restrict in);
-int	symbol_outer	(const img_s *restrict sym, img_s *restrict out);
+int	extract_symbols	(struct Ctx *ctx);
+int	clean_symbol	(struct Ctx *ctx, ptrdiff_t i);
+int	split_symbol	(struct Ctx *ctx, ptrdiff_t i);
+int	symbol_inner	(struct Ctx *ctx, ptrdiff_t i);
+int	symbol_outer	(struct Ctx *ctx, ptrdiff_t i);
 
 
 /******************************************************************************
@@ -0,0 +1,224 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "tasks.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "pool.h"
+#include "prof.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+struct	Helper {
+	struct Tasks	*tasks;
+	pthread_t	thr;
+	/* Owned by the thread */
+	struct Prof	*prof;
+};
+
+struct	Tasks {
+	struct Helper		*h;
+	int			nhelpers;
+	pthread_mutex_t		mutex;
+	pthread_cond_t		start;
+	pthread_cond_t		done;
+	/* The current run;  a new one starts when gen changes */
+	unsigned		gen;
+	bool			quit;
+	int			ndone;
+	task_f			*f;
+	void			*arg;
+	ptrdiff_t		n;
+	int			prof;
+	atomic_ptrdiff_t	next;
+};
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+void	*helper		(void *arg);
+static
+void	work		(struct Tasks *restrict tasks,
+			 struct Prof *restrict prof);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+int	init_tasks	(struct Tasks **tasks, int nthr)
+{
+	struct Tasks	*t;
+
+	*tasks	= NULL;
+	if (nthr < 2)
+		return	0;
+	t	= calloc(1, sizeof(*t));
+	if (!t)
+		return	-1;
+	t->h	= calloc(nthr - 1, sizeof(*t->h));
+	if (!t->h)
+		goto err0;
+	if (pthread_mutex_init(&t->mutex, NULL))
+		goto err1;
+	if (pthread_cond_init(&t->start, NULL))
+		goto err2;
+	if (pthread_cond_init(&t->done, NULL))
+		goto err3;
+	atomic_init(&t->next, 0);
+	for (t->nhelpers = 0; t->nhelpers < nthr - 1; t->nhelpers++) {
+		t->h[t->nhelpers].tasks	= t;
+		if (pthread_create(&t->h[t->nhelpers].thr, NULL, &helper,
+							&t->h[t->nhelpers])) {
+			deinit_tasks(t);
+			return	-1;
+		}
+	}
+
+	*tasks	= t;
+	return	0;
+
+err3:	pthread_cond_destroy(&t->start);
+err2:	pthread_mutex_destroy(&t->mutex);
+err1:	free(t->h);
+err0:	free(t);
+	return	-1;
+}
+
+void	deinit_tasks	(struct Tasks *tasks)
+{
+
+	if (!tasks)
+		return;
+	pthread_mutex_lock(&tasks->mutex);
+	tasks->quit	= true;
+	pthread_cond_broadcast(&tasks->start);
+	pthread_mutex_unlock(&tasks->mutex);
+	for (int i = 0; i < tasks->nhelpers; i++)
+		pthread_join(tasks->h[i].thr, NULL);
+
+	pthread_cond_destroy(&tasks->done);
+	pthread_cond_destroy(&tasks->start);
+	pthread_mutex_destroy(&tasks->mutex);
+	free(tasks->h);
+	free(tasks);
+}
+
+/*
+ * Run f(arg, i, ...) for every i in [0, n), and return when all of them
+ * are done.  The calling thread takes part, with prof;  the records of the
+ * other threads are moved to prof at the end.  With no tasks (NULL), the
+ * calling thread runs them in order.
+ */
+void	tasks_run	(struct Tasks *restrict tasks, task_f *f,
+			 void *restrict arg, ptrdiff_t n,
+			 struct Prof *restrict prof)
+{
+
+	if (!tasks) {
+		for (ptrdiff_t i = 0; i < n; i++)
+			f(arg, i, prof);
+		return;
+	}
+
+	pthread_mutex_lock(&tasks->mutex);
+	tasks->f	= f;
+	tasks->arg	= arg;
+	tasks->n	= n;
+	tasks->prof	= prof_mode(prof);
+	tasks->ndone	= 0;
+	atomic_store(&tasks->next, 0);
+	tasks->gen++;
+	pthread_cond_broadcast(&tasks->start);
+	pthread_mutex_unlock(&tasks->mutex);
+
+	work(tasks, prof);
+
+	pthread_mutex_lock(&tasks->mutex);
+	while (tasks->ndone < tasks->nhelpers)
+		pthread_cond_wait(&tasks->done, &tasks->mutex);
+	pthread_mutex_unlock(&tasks->mutex);
+	for (int i = 0; i < tasks->nhelpers; i++)
+		prof_merge(prof, tasks->h[i].prof);
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+static
+void	*helper		(void *arg)
+{
+	struct Helper	*h;
+	struct Tasks	*t;
+	struct Pool	*pool;
+	unsigned	gen;
+
+	h	= arg;
+	t	= h->tasks;
+	/* Without a pool, the scratch objects are just allocated */
+	if (init_pool(&pool))
+		pool	= NULL;
+	pool_bind(pool);
+
+	gen	= 0;
+	pthread_mutex_lock(&t->mutex);
+	for (;;) {
+		while (!t->quit && t->gen == gen)
+			pthread_cond_wait(&t->start, &t->mutex);
+		if (t->quit)
+			break;
+		gen	= t->gen;
+		pthread_mutex_unlock(&t->mutex);
+
+		/* The counters have to be opened by the thread they count */
+		if (prof_mode(h->prof) != t->prof) {
+			deinit_prof(h->prof);
+			init_prof(&h->prof, t->prof);
+		}
+		work(t, h->prof);
+
+		pthread_mutex_lock(&t->mutex);
+		if (++t->ndone == t->nhelpers)
+			pthread_cond_signal(&t->done);
+	}
+	pthread_mutex_unlock(&t->mutex);
+
+	deinit_prof(h->prof);
+	deinit_pool(pool);
+	return	NULL;
+}
+
+static
+void	work		(struct Tasks *restrict tasks,
+			 struct Prof *restrict prof)
+{
+	ptrdiff_t	i;
+
+	while ((i = atomic_fetch_add(&tasks->next, 1)) < tasks->n)
+		tasks->f(tasks->arg, i, prof);
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,68 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* tasks.h */
+
+
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * A few threads, kept for the life of a context, that share with the
+ * calling thread the tasks of a tasks_run() (e.g., the symbols of a label,
+ * which are independent once extracted).  Every thread has its own scratch
+ * pool (see pool.h) and, while profiling, its own counters.
+ */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include <stddef.h>
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+struct	Prof;
+struct	Tasks;
+
+/* Task i of arg;  prof is the profile of the thread that runs it (or NULL) */
+typedef	void	task_f	(void *arg, ptrdiff_t i, struct Prof *prof);
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+/* nthr threads in total, counting the caller;  less than 2 sets NULL */
+int	init_tasks	(struct Tasks **tasks, int nthr);
+void	deinit_tasks	(struct Tasks *tasks);
+void	tasks_run	(struct Tasks *restrict tasks, task_f *f,
+			 void *restrict arg, ptrdiff_t n,
+			 struct Prof *restrict prof);
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -20,8 +20,11 @@
 #include <libalx/base/stdio.h>
 #include <libalx/extra/cv/cv.h>
 
+#include "bits.h"
+#include "ccl.h"
+#include "ctx.h"
 #include "dbg.h"
-#include "symbols.h"
+#include "pool.h"
 #include "templates/templates.h"
 
 
@@ -43,50 +46,44 @@
 /******************************************************************************
  ******* static prototypes ****************************************************
  ******************************************************************************/
+static
+void	show_diff	(const img_s *restrict sym, const img_s *restrict t);
 
 
 /******************************************************************************
  ******* global functions *****************************************************
  ******************************************************************************/
-int	match_t_base	(img_s *restrict sym, uint32_t *code, ptrdiff_t i)
+int	match_t_base	(const struct Ctx *ctx, ptrdiff_t i, uint32_t *code)
 {
-	img_s		*base;
-	img_s		*tmp;
-	conts_s		*conts;
-	double		match, m;
-	int		status;
+	const img_s	*base;
+	struct Bits	b;
+	double		match;
+	double		m;
+	ptrdiff_t	k;
 
 	/* init */
-	status	= -1;
-	if (alx_cv_init_img(&base))
-		return	status;
-	if (alx_cv_init_img(&tmp))
-		goto err0;
-	if (alx_cv_init_conts(&conts))
-		goto err1;
+	base	= ctx->part[i].base;				dbg_show(2, base);
+	k	= t_pack(&b, base);
+	if (k < 0)
+		return	-1;
 
 	/* Find base match */
-	status--;
-	if (symbol_base(sym, base))
-		goto err;					dbg_show(2, base);
-	status--;
 	match	= -INFINITY;
 	BITFIELD_SET(code, CODE_BASE_POS, CODE_BASE_LEN);
 
-	m = alx_cv_compare_bitwise(base, base_templates[i], 2);	dbg_printf(4, "match: %.5lf\n", m);
-	alx_cv_clone(tmp, base);
-	alx_cv_resize_2largest(tmp, base_templates[i]);
-	alx_cv_xor_2ref(tmp, base_templates[i]);		dbg_show(2, tmp);
+	m = bits_match(&b, &ctx->t->bits[k][i], 2);		dbg_printf(4, "match: %.5lf\n", m);
+	if (DBG >= 2)
+		show_diff(base, ctx->t->base[i]);
 	if (m >= match) {
 		BITFIELD_WRITE(code, CODE_BASE_POS, CODE_BASE_LEN, i);
 		BIT_SET(code, CODE_Y_N_POS);
 		match	= m;
 	}
 
-	m = alx_cv_compare_bitwise(base, base_templates_not[i], 2);	dbg_printf(4, "match: %.5lf\n", m);
-	alx_cv_clone(tmp, base);
-	alx_cv_resize_2largest(tmp, base_templates_not[i]);
-	alx_cv_xor_2ref(tmp, base_templates_not[i]);		dbg_show(2, tmp);
+	m = bits_match(&b, &ctx->t->bits[k][T_BASE_QTY + i], 2);
+								dbg_printf(4, "match: %.5lf\n", m);
+	if (DBG >= 2)
+		show_diff(base, ctx->t->base_not[i]);
 	if (m >= match) {
 		BITFIELD_WRITE(code, CODE_BASE_POS, CODE_BASE_LEN, i);
 		BIT_CLEAR(code, CODE_Y_N_POS);
@@ -95,30 +92,27 @@ int	match_t_base	(img_s *restrict sym, uint32_t *code, ptrdiff_t i)
 
 	if (BIT_READ(*code, CODE_Y_N_POS)) {
 								dbg_printf(4, "%s\n", t_base_meaning[i]);
-								dbg_show(1, base_templates[i]);
+								dbg_show(1, ctx->t->base[i]);
 	} else {
 								dbg_printf(4, "%s not\n", t_base_meaning[i]);
-								dbg_show(1, base_templates_not[i]);
+								dbg_show(1, ctx->t->base_not[i]);
 	}
 
 	/* deinit */
-	status	= 0;
-err:	alx_cv_deinit_conts(conts);
-err1:	alx_cv_deinit_img(tmp);
-err0:	alx_cv_deinit_img(base);
-	return	status;
+	bits_deinit(&b);
+	return	0;
 }
 
 int	load_t_base		(img_s *t, const char *fname)
 {
-	conts_s		*conts;
-	const cont_s	*cont;
+	struct Ccl	*ccl;
 	rect_s		*rect;
+	ptrdiff_t	i;
 	int		status;
 
 	/* init */
 	status	= -1;
-	if (alx_cv_init_conts(&conts))
+	if (init_ccl(&ccl))
 		return	status;
 	if (alx_cv_init_rect(&rect))
 		goto err0;
@@ -127,17 +121,19 @@ int	load_t_base		(img_s *t, const char *fname)
 	if (alx_cv_imread_gray(t, fname))
 		goto err;					dbg_show(4, t);
 	alx_cv_threshold(t, ALX_CV_THRESH_BINARY_INV, ALX_CV_THR_OTSU);
-	alx_cv_contours(t, conts);
 	status--;
-	if (alx_cv_conts_largest_a(&cont, NULL, conts))
+	if (ccl_label(ccl, t))
+		goto err;
+	i	= ccl_largest_a(ccl);
+	if (i < 0)
 		goto err;
-	alx_cv_bounding_rect(rect, cont);
+	ccl_bounding_rect(rect, ccl, i);
 	alx_cv_roi_set(t, rect);				dbg_show(4, t);
 
 	/* deinit */
 	status	= 0;
 err:	alx_cv_deinit_rect(rect);
-err0:	alx_cv_deinit_conts(conts);
+err0:	deinit_ccl(ccl);
 	return	status;
 }
 
@@ -145,6 +141,24 @@ err0:	alx_cv_deinit_conts(conts);
 /******************************************************************************
  ******* static function definitions ******************************************
  ******************************************************************************/
+/* Where sym and t differ;  t is shared, so it's resized only as a copy */
+static
+void	show_diff	(const img_s *restrict sym, const img_s *restrict t)
+{
+	img_s	*diff, *ref;
+
+	if (pool_get_img(&diff))
+		return;
+	if (pool_get_img(&ref))
+		goto err;
+	alx_cv_clone(diff, sym);
+	alx_cv_clone(ref, t);
+	alx_cv_resize_2largest(diff, ref);
+	alx_cv_xor_2ref(diff, ref);				dbg_show(2, diff);
+
+	pool_put_img(ref);
+err:	pool_put_img(diff);
+}
 
 
 /******************************************************************************
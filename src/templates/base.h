@@ -18,6 +18,8 @@
 #include <libalx/base/compiler.h>
 #include <libalx/extra/cv/cv.h>
 
+#include "ctx.h"
+
 
 /******************************************************************************
  ******* macros ***************************************************************
@@ -43,7 +45,7 @@
  ******* prototypes ***********************************************************
  ******************************************************************************/
 int	load_t_base	(img_s *t, const char *fname);
-int	match_t_base	(img_s *restrict sym, uint32_t *code, ptrdiff_t i);
+int	match_t_base	(const struct Ctx *ctx, ptrdiff_t i, uint32_t *code);
 
 
 /******************************************************************************
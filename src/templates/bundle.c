@@ -0,0 +1,331 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "templates/bundle.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ALX_NO_PREFIX
+#include <libalx/base/compiler.h>
+#include <libalx/base/errno.h>
+#include <libalx/base/stdio.h>
+#include <libalx/extra/cv/cv.h>
+
+#include "cvx.h"
+#include "templates/templates.h"
+
+
+/******************************************************************************
+ ******* macro ****************************************************************
+ ******************************************************************************/
+#define T_BUNDLE_MAGIC		"LSR-TPL"
+#define T_BUNDLE_VERSION	(3)
+/* Alignment of every image, and of every line in it */
+#define T_BUNDLE_ALIGN		(64)
+
+#define t_bundle_align(x)	(((x) + T_BUNDLE_ALIGN - 1) & ~(T_BUNDLE_ALIGN - 1))
+
+
+/******************************************************************************
+ ******* enum / struct / union ************************************************
+ ******************************************************************************/
+/* The PNG that an image was built from, to know when the bundle is stale */
+struct	T_Bundle_Src {
+	int64_t		mtime_sec;
+	int64_t		mtime_nsec;
+	int64_t		size;
+};
+
+struct	T_Bundle_Img {
+	uint64_t	off;
+	uint32_t	w;
+	uint32_t	h;
+	uint32_t	step;
+	uint32_t	pad;
+};
+
+/*
+ * Images follow in the order of t_img(), each at hdr.img[i].off, and then
+ * the packed templates (t->packed) at hdr.packed_off.
+ */
+struct	T_Bundle_Hdr {
+	char			magic[8];
+	uint32_t		version;
+	uint32_t		n;
+	uint32_t		prep;	/* T_PREP_VERSION */
+	uint32_t		pad;
+	uint64_t		size;
+	uint64_t		packed_off;
+	uint64_t		packed_size;
+	uint64_t		packed_version[2];	/* t->version */
+	struct T_Bundle_Src	src[T_QTY];
+	struct T_Bundle_Img	img[T_QTY];
+};
+
+
+/******************************************************************************
+ ******* static prototypes ****************************************************
+ ******************************************************************************/
+static
+int	src_stat	(struct T_Bundle_Src *restrict src,
+			 const char *restrict dir, ptrdiff_t i);
+static
+int	write_all	(int fd, const void *buf, size_t size);
+
+
+/******************************************************************************
+ ******* global functions *****************************************************
+ ******************************************************************************/
+/*
+ * Write <dir>/templates.bundle from the templates in t (loaded from the PNGs
+ * in dir, and packed).  The file is replaced atomically, so processes that have the old
+ * one mapped keep working.
+ */
+int	t_bundle_write	(const struct Templates *restrict t,
+			 const char *restrict dir)
+{
+	struct T_Bundle_Hdr	*hdr;
+	char			fname[FILENAME_MAX];
+	char			tmp[FILENAME_MAX];
+	unsigned char		*buf;
+	void			*data;
+	ptrdiff_t		w, h, B_per_pix, B_per_line;
+	size_t			off;
+	int			type;
+	int			fd;
+	int			status;
+
+	status	= -1;
+	if (!t->packed)
+		return	status;
+	if (sbprintf(fname, NULL, "%s/%s", dir, T_BUNDLE_FNAME))
+		return	status;
+	if (sbprintf(tmp, NULL, "%s.XXXXXX", fname))
+		return	status;
+
+	off	= t_bundle_align(sizeof(*hdr));
+	for (ptrdiff_t i = 0; i < T_QTY; i++) {
+		alx_cv_extract_imgdata(t_img(t, i), &data, &w, &h, &B_per_pix,
+							&B_per_line, &type);
+		off	+= t_bundle_align(w) * h;
+	}
+	off	+= t_bits_size();
+	status--;
+	buf	= calloc(1, off);
+	if (!buf)
+		return	status;
+
+	hdr	= (struct T_Bundle_Hdr *)buf;
+	memcpy(hdr->magic, T_BUNDLE_MAGIC, sizeof(T_BUNDLE_MAGIC));
+	hdr->version	= T_BUNDLE_VERSION;
+	hdr->n		= T_QTY;
+	hdr->prep	= T_PREP_VERSION;
+	hdr->size	= off;
+	hdr->packed_size	= t_bits_size();
+	memcpy(hdr->packed_version, t->version, sizeof(t->version));
+	off	= t_bundle_align(sizeof(*hdr));
+	status--;
+	for (ptrdiff_t i = 0; i < T_QTY; i++) {
+		if (src_stat(&hdr->src[i], dir, i))
+			goto err0;
+		alx_cv_extract_imgdata(t_img(t, i), &data, &w, &h, &B_per_pix,
+							&B_per_line, &type);
+		if (B_per_pix != 1)
+			goto err0;
+		hdr->img[i].off		= off;
+		hdr->img[i].w		= w;
+		hdr->img[i].h		= h;
+		hdr->img[i].step	= t_bundle_align(w);
+		for (ptrdiff_t j = 0; j < h; j++) {
+			memcpy(buf + off, (unsigned char *)data + j * B_per_line,
+									w);
+			off	+= hdr->img[i].step;
+		}
+	}
+	hdr->packed_off	= off;
+	memcpy(buf + off, t->packed, hdr->packed_size);
+	off	+= hdr->packed_size;
+
+	status--;
+	fd	= mkstemp(tmp);
+	if (fd < 0)
+		goto err0;
+	if (write_all(fd, buf, off))
+		goto err1;
+	if (fchmod(fd, 0644))
+		goto err1;
+	if (fsync(fd))
+		goto err1;
+	if (rename(tmp, fname))
+		goto err1;
+
+	status	= 0;
+	close(fd);
+	free(buf);
+	return	status;
+
+err1:	close(fd);
+	unlink(tmp);
+err0:	free(buf);
+	perrorx("[error]	write %s: %i\n", fname, status);
+	return	status;
+}
+
+/*
+ * Map <dir>/templates.bundle and point every template, and every packed
+ * template, at its data;  nothing is copied.
+ * Returns 0 on success, T_BUNDLE_MISSING or T_BUNDLE_STALE if the PNGs
+ * have to be loaded instead, and a negative value on error.  A PNG that is
+ * missing doesn't make the bundle stale:  it can be installed alone.
+ */
+int	t_bundle_map	(struct Templates *restrict t, const char *restrict dir)
+{
+	const struct T_Bundle_Hdr	*hdr;
+	struct T_Bundle_Src		src;
+	char				fname[FILENAME_MAX];
+	struct stat			st;
+	void				*map;
+	int				fd;
+	int				status;
+
+	status	= -1;
+	if (sbprintf(fname, NULL, "%s/%s", dir, T_BUNDLE_FNAME))
+		return	status;
+	fd	= open(fname, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return	errno == ENOENT ? T_BUNDLE_MISSING : status;
+	status--;
+	if (fstat(fd, &st))
+		goto err;
+	status	= T_BUNDLE_STALE;
+	if ((size_t)st.st_size < sizeof(*hdr))
+		goto err;
+	status	= -3;
+	map	= mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+		goto err;
+	close(fd);
+
+	hdr	= map;
+	status	= T_BUNDLE_STALE;
+	if (memcmp(hdr->magic, T_BUNDLE_MAGIC, sizeof(T_BUNDLE_MAGIC)))
+		goto unmap;
+	if (hdr->version != T_BUNDLE_VERSION || hdr->n != T_QTY)
+		goto unmap;
+	/* Built from the same PNGs, but preprocessed differently */
+	if (hdr->prep != T_PREP_VERSION)
+		goto unmap;
+	if (hdr->size != (uint64_t)st.st_size)
+		goto unmap;
+	if (hdr->packed_size != t_bits_size())
+		goto unmap;
+	if (hdr->packed_off % T_BUNDLE_ALIGN)
+		goto unmap;
+	if (hdr->packed_off > hdr->size ||
+	    hdr->size - hdr->packed_off < hdr->packed_size)
+		goto unmap;
+	for (ptrdiff_t i = 0; i < T_QTY; i++) {
+		if (!hdr->img[i].step || hdr->img[i].step < hdr->img[i].w)
+			goto unmap;
+		if (hdr->img[i].off > hdr->size)
+			goto unmap;
+		if ((hdr->size - hdr->img[i].off) / hdr->img[i].step
+							< hdr->img[i].h)
+			goto unmap;
+		if (src_stat(&src, dir, i)) {
+			if (errno == ENOENT)
+				continue;
+			goto unmap;
+		}
+		if (memcmp(&src, &hdr->src[i], sizeof(src)))
+			goto unmap;
+	}
+
+	/* The templates point into the map from now on */
+	t->map		= map;
+	t->map_size	= st.st_size;
+	status	= -4;
+	for (ptrdiff_t i = 0; i < T_QTY; i++) {
+		if (cvx_wrap_gray(t_img(t, i),
+				(const unsigned char *)map + hdr->img[i].off,
+				hdr->img[i].w, hdr->img[i].h,
+				hdr->img[i].step))
+			return	status;
+	}
+	/* Only read, as the map */
+	t_bits_init(t, (char *)map + hdr->packed_off);
+	memcpy(t->version, hdr->packed_version, sizeof(t->version));
+	return	0;
+
+unmap:	munmap(map, st.st_size);
+	return	status;
+err:	close(fd);
+	return	status;
+}
+
+/* Only after the templates that point into the map are gone */
+void	t_bundle_unmap	(struct Templates *t)
+{
+
+	if (t->map)
+		munmap(t->map, t->map_size);
+	t->map		= NULL;
+	t->map_size	= 0;
+}
+
+
+/******************************************************************************
+ ******* static function definitions ******************************************
+ ******************************************************************************/
+static
+int	src_stat	(struct T_Bundle_Src *restrict src,
+			 const char *restrict dir, ptrdiff_t i)
+{
+	char		fname[FILENAME_MAX];
+	struct stat	st;
+
+	if (t_fname(fname, dir, i))
+		return	-1;
+	if (stat(fname, &st))
+		return	-1;
+	memset(src, 0, sizeof(*src));
+	src->mtime_sec	= st.st_mtim.tv_sec;
+	src->mtime_nsec	= st.st_mtim.tv_nsec;
+	src->size	= st.st_size;
+	return	0;
+}
+
+static
+int	write_all	(int fd, const void *buf, size_t size)
+{
+	const unsigned char	*p;
+	ssize_t			len;
+
+	for (p = buf; size; p += len, size -= len) {
+		len	= write(fd, p, size);
+		if (len < 0)
+			return	-1;
+	}
+	return	0;
+}
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -0,0 +1,68 @@
+/******************************************************************************
+ *	Copyright (C) 2020	Alejandro Colomar Andrés		      *
+ *	SPDX-License-Identifier:	GPL-2.0-only			      *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* include guard ********************************************************
+ ******************************************************************************/
+#pragma once	/* templates/bundle.h */
+
+
+/******************************************************************************
+ ******* about ****************************************************************
+ ******************************************************************************/
+/*
+ * A bundle is every template, already preprocessed and packed at every
+ * size, in one file that is mapped read-only and used in place:  loading the
+ * templates costs an mmap() instead of decoding, preprocessing and packing
+ * 25 PNGs, and every process that maps it shares the same pages.
+ */
+
+
+/******************************************************************************
+ ******* headers **************************************************************
+ ******************************************************************************/
+#include "templates/templates.h"
+
+
+/******************************************************************************
+ ******* macros ***************************************************************
+ ******************************************************************************/
+#define T_BUNDLE_FNAME	"templates.bundle"
+
+
+/******************************************************************************
+ ******* enum *****************************************************************
+ ******************************************************************************/
+/* Positive return values of t_bundle_map() */
+enum	T_Bundle_Status {
+	T_BUNDLE_OK,
+	T_BUNDLE_MISSING,
+	T_BUNDLE_STALE
+};
+
+
+/******************************************************************************
+ ******* struct / union *******************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* prototypes ***********************************************************
+ ******************************************************************************/
+int	t_bundle_write	(const struct Templates *restrict t,
+			 const char *restrict dir);
+int	t_bundle_map	(struct Templates *restrict t, const char *restrict dir);
+void	t_bundle_unmap	(struct Templates *t);
+
+
+/******************************************************************************
+ ******* inline ***************************************************************
+ ******************************************************************************/
+
+
+/******************************************************************************
+ ******* end of file **********************************************************
+ ******************************************************************************/
@@ -13,16 +13,25 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+
+#include <sys/param.h>
 
 #define ALX_NO_PREFIX
 #include <libalx/base/compiler.h>
+#include <libalx/base/errno.h>
 #include <libalx/base/stdint.h>
 #include <libalx/base/stdio.h>
 #include <libalx/extra/cv/cv.h>
 
+#include "bits.h"
+#include "ccl.h"
+#include "ctx.h"
 #include "dbg.h"
-#include "symbols.h"
+#include "hash.h"
+#include "morph.h"
 #include "templates/base.h"
+#include "templates/bundle.h"
 
 
 /******************************************************************************
@@ -95,177 +104,332 @@ const char *const	t_outer_meaning[] = {
 	"very delicate"
 };
 
-img_s	*base_templates[ARRAY_SIZE(t_base_fnames)];
-img_s	*base_templates_not[ARRAY_SIZE(t_base_fnames)];
-img_s	*inner_templates[ARRAY_SIZE(t_inner_fnames)];
+#define X	(-1)
+const struct T_Grammar	t_grammar[] = {
+	[T_BASE_WASH]	= {
+		.inner	= {
+			[T_INNER_FNAME_1_DOT]	= T_INNER_30,
+			[T_INNER_FNAME_2_DOT]	= T_INNER_40,
+			[T_INNER_FNAME_3_DOT]	= T_INNER_50,
+			[T_INNER_FNAME_4_DOT]	= T_INNER_60,
+			[T_INNER_FNAME_5_DOT]	= T_INNER_70,
+			[T_INNER_FNAME_6_DOT]	= T_INNER_95,
+			[T_INNER_FNAME_30]	= T_INNER_30,
+			[T_INNER_FNAME_40]	= T_INNER_40,
+			[T_INNER_FNAME_50]	= T_INNER_50,
+			[T_INNER_FNAME_60]	= T_INNER_60,
+			[T_INNER_FNAME_95]	= T_INNER_95,
+			[T_INNER_FNAME_A ... T_INNER_FNAME_W]	= T_INNER_EMPTY,
+		},
+	},
+	/* Any bleach is fine;  the inner field is set */
+	[T_BASE_BLEACH]	= {
+		.inner	= {
+			[T_INNER_FNAME_1_DOT ... T_INNER_FNAME_W]	= X,
+		},
+	},
+	[T_BASE_DRY]	= {
+		.inner	= {
+			[T_INNER_FNAME_1_DOT]	= T_INNER_LO_T,
+			[T_INNER_FNAME_2_DOT]	= T_INNER_MED_T,
+			[T_INNER_FNAME_3_DOT]	= T_INNER_HI_T,
+			[T_INNER_FNAME_4_DOT ... T_INNER_FNAME_W]	= T_INNER_EMPTY,
+		},
+	},
+	[T_BASE_IRON]	= {
+		.inner	= {
+			[T_INNER_FNAME_1_DOT]	= T_INNER_LO_T,
+			[T_INNER_FNAME_2_DOT]	= T_INNER_MED_T,
+			[T_INNER_FNAME_3_DOT]	= T_INNER_HI_T,
+			[T_INNER_FNAME_4_DOT ... T_INNER_FNAME_W]	= T_INNER_EMPTY,
+		},
+	},
+	[T_BASE_PRO]	= {
+		.inner	= {
+			[T_INNER_FNAME_1_DOT ... T_INNER_FNAME_95]	= T_INNER_EMPTY,
+			[T_INNER_FNAME_A]	= T_INNER_A,
+			[T_INNER_FNAME_F]	= T_INNER_F,
+			[T_INNER_FNAME_P]	= T_INNER_P,
+			[T_INNER_FNAME_W]	= T_INNER_W,
+		},
+	},
+};
+#undef X
 
 
 /******************************************************************************
  ******* static prototypes ****************************************************
  ******************************************************************************/
 static
-int	load_t_inner		(img_s *t, const char *fname);
+int	pack_templates		(struct Templates *t);
 static
-void	t_inner_fix_code	(uint32_t *code);
+int	load_t_inner		(img_s *t, const char *fname);
 
 
 /******************************************************************************
  ******* global functions *****************************************************
  ******************************************************************************/
-int	init_templates	(void)
+int	init_templates	(struct Templates **t)
 {
-	ptrdiff_t	i;
-	ptrdiff_t	j;
-	ptrdiff_t	k;
-
-	for (i = 0; i < ARRAY_SSIZE(base_templates); i++) {
-		if (alx_cv_init_img(&base_templates[i]))
+	struct Templates	*tt;
+	ptrdiff_t		i;
+	ptrdiff_t		j;
+	ptrdiff_t		k;
+
+	tt	= malloc(sizeof(*tt));
+	if (!tt)
+		return	-1;
+	for (i = 0; i < ARRAY_SSIZE(tt->base); i++) {
+		if (alx_cv_init_img(&tt->base[i]))
 			goto err0;
 	}
-	for (j = 0; j < ARRAY_SSIZE(base_templates_not); j++) {
-		if (alx_cv_init_img(&base_templates_not[j]))
+	for (j = 0; j < ARRAY_SSIZE(tt->base_not); j++) {
+		if (alx_cv_init_img(&tt->base_not[j]))
 			goto err1;
 	}
-	for (k = 0; k < ARRAY_SSIZE(inner_templates); k++) {
-		if (alx_cv_init_img(&inner_templates[k]))
+	for (k = 0; k < ARRAY_SSIZE(tt->inner); k++) {
+		if (alx_cv_init_img(&tt->inner[k]))
 			goto err2;
 	}
 
+	tt->packed	= NULL;
+	tt->map		= NULL;
+	tt->map_size	= 0;
+
+	*t	= tt;
 	return	0;
 
 err2:	for (k--; k >= 0; k--)
-		alx_cv_deinit_img(inner_templates[k]);
+		alx_cv_deinit_img(tt->inner[k]);
 err1:	for (j--; j >= 0; j--)
-		alx_cv_deinit_img(base_templates_not[j]);
+		alx_cv_deinit_img(tt->base_not[j]);
 err0:	for (i--; i >= 0; i--)
-		alx_cv_deinit_img(base_templates[i]);
+		alx_cv_deinit_img(tt->base[i]);
+	free(tt);
 	return	-1;
 }
 
-void	deinit_templates(void)
+void	deinit_templates(struct Templates *t)
 {
 
-	alx_cv_destroy_all_windows();
-	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(inner_templates); i++)
-		alx_cv_deinit_img(inner_templates[i]);
-	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(base_templates_not); i++)
-		alx_cv_deinit_img(base_templates_not[i]);
-	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(base_templates); i++)
-		alx_cv_deinit_img(base_templates[i]);
+	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(t->inner); i++)
+		alx_cv_deinit_img(t->inner[i]);
+	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(t->base_not); i++)
+		alx_cv_deinit_img(t->base_not[i]);
+	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(t->base); i++)
+		alx_cv_deinit_img(t->base[i]);
+	free(t->packed);
+	t_bundle_unmap(t);
+	free(t);
 }
 
-int	load_templates	(void)
+/*
+ * Use the precompiled bundle if it's there and up to date (it's already
+ * packed);  otherwise, load (and preprocess) the PNGs.
+ */
+int	load_templates	(struct Templates *restrict t, const char *restrict dir)
+{
+	int	status;
+
+	status	= t_bundle_map(t, dir);
+	if (!status)
+		return	0;
+	if (status == T_BUNDLE_STALE)
+		perrorx("[warning]	templates bundle is stale; loading PNGs\n");
+	else if (status < 0)
+		perrorx("[warning]	templates bundle: %i; loading PNGs\n",
+									status);
+	return	load_templates_png(t, dir);
+}
+
+/* And pack them at every size */
+int	load_templates_png(struct Templates *restrict t,
+			 const char *restrict dir)
 {
 	char	fname[FILENAME_MAX];
 
-	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(base_templates); i++) {
-		if (sbprintf(fname, NULL, "%s/%s.%s", T_BASE_DIR,
-					t_base_fnames[i], TEMPLATES_EXT))
+	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(t->base); i++) {
+		if (t_fname(fname, dir, i))
 			return	i + 110;
-		if (load_t_base(base_templates[i], fname))
+		if (load_t_base(t->base[i], fname))
 			return	i + 120;
 	}
-	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(base_templates); i++) {
-		if (sbprintf(fname, NULL, "%s/%s_not.%s", T_BASE_DIR,
-					t_base_fnames[i], TEMPLATES_EXT))
+	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(t->base_not); i++) {
+		if (t_fname(fname, dir, T_BASE_QTY + i))
 			return	i + 210;
-		if (load_t_base(base_templates_not[i], fname))
+		if (load_t_base(t->base_not[i], fname))
 			return	i + 220;
 	}
-	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(inner_templates); i++) {
-		if (sbprintf(fname, NULL, "%s/%s.%s", T_INNER_DIR,
-					t_inner_fnames[i], TEMPLATES_EXT))
+	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(t->inner); i++) {
+		if (t_fname(fname, dir, 2 * T_BASE_QTY + i))
 			return	i + 310;
-		if (load_t_inner(inner_templates[i], fname))
+		if (load_t_inner(t->inner[i], fname))
 			return	i + 320;
 	}
+	if (pack_templates(t))
+		return	400;
 	return	0;
 }
 
-int	match_t_inner	(img_s *restrict sym, uint32_t *code)
+/* All the templates, in the order:  base, base not, inner */
+img_s	*t_img		(const struct Templates *t, ptrdiff_t i)
 {
-	img_s		*in;
-	conts_s		*conts;
-	double		match, m;
-	int		status;
+
+	if (i < T_BASE_QTY)
+		return	t->base[i];
+	i	-= T_BASE_QTY;
+	if (i < T_BASE_QTY)
+		return	t->base_not[i];
+	i	-= T_BASE_QTY;
+	return	t->inner[i];
+}
+
+/*
+ * Pack img into b, at the size of the templates to match it against
+ * (see T_SIZES).  Returns that size (k in T_SIZE(k)), or -1.  b is scratch
+ * memory;  see bits_deinit().
+ */
+ptrdiff_t t_pack	(struct Bits *restrict b, const img_s *restrict img)
+{
+	ptrdiff_t	w, h, k;
+
+	alx_cv_extract_imgdata(img, NULL, &w, &h, NULL, NULL, NULL);
+	for (k = 0; k < T_SIZES - 1; k++) {
+		if (T_SIZE(k) >= MAX(w, h))
+			break;
+	}
+
+	if (bits_init(b, T_SIZE(k), T_SIZE(k)))
+		return	-1;
+	if (bits_pack(b, img)) {
+		bits_deinit(b);
+		return	-1;
+	}
+	return	k;
+}
+
+/* Of the templates packed at every size */
+size_t	t_bits_size	(void)
+{
+	size_t	size;
+
+	size	= 0;
+	for (ptrdiff_t k = 0; k < T_SIZES; k++)
+		size	+= T_QTY * bits_size(T_SIZE(k), T_SIZE(k));
+	return	size;
+}
+
+/* Point the packed templates at packed (t_bits_size() bytes) */
+void	t_bits_init	(struct Templates *restrict t, void *restrict packed)
+{
+	char	*p;
+
+	p	= packed;
+	for (ptrdiff_t k = 0; k < T_SIZES; k++) {
+		for (ptrdiff_t i = 0; i < T_QTY; i++) {
+			bits_init_buf(&t->bits[k][i], p, T_SIZE(k), T_SIZE(k));
+			p	+= bits_size(T_SIZE(k), T_SIZE(k));
+		}
+	}
+}
+
+int	t_fname		(char fname[FILENAME_MAX], const char *restrict dir,
+			 ptrdiff_t i)
+{
+
+	if (i < T_BASE_QTY)
+		return	sbprintf(fname, NULL, "%s/%s/%s.%s", dir, T_BASE_DIR,
+					t_base_fnames[i], TEMPLATES_EXT);
+	i	-= T_BASE_QTY;
+	if (i < T_BASE_QTY)
+		return	sbprintf(fname, NULL, "%s/%s/%s_not.%s", dir,
+					T_BASE_DIR, t_base_fnames[i],
+					TEMPLATES_EXT);
+	i	-= T_BASE_QTY;
+	return	sbprintf(fname, NULL, "%s/%s/%s.%s", dir, T_INNER_DIR,
+					t_inner_fnames[i], TEMPLATES_EXT);
+}
+
+/* If the base of code (already matched) can have something inside */
+bool	t_reads_inner	(uint32_t code)
+{
+	const struct T_Grammar	*g;
+
+	if (!BIT_READ(code, CODE_Y_N_POS))
+		return	false;
+	g	= &t_grammar[BITFIELD_READ(code, CODE_BASE_POS, CODE_BASE_LEN)];
+	for (ptrdiff_t j = 0; j < ARRAY_SSIZE(g->inner); j++) {
+		if (g->inner[j] >= 0)
+			return	true;
+	}
+	return	false;
+}
+
+/*
+ * Only the inner templates that the grammar compares in the base are tried,
+ * in order (the last of equal matches wins).
+ */
+int	match_t_inner	(const struct Ctx *ctx, ptrdiff_t i, uint32_t *code)
+{
+	const struct T_Grammar	*g;
+	const img_s		*in;
+	struct Bits		b;
+	double			match, m;
+	ptrdiff_t		best;
+	ptrdiff_t		k;
 
 	if (!BIT_READ(*code, CODE_Y_N_POS)) {
 		BITFIELD_CLEAR(code, CODE_IN_POS, CODE_IN_LEN);
 		return	1;
 	}
-
-	/* init */
-	status	= -1;
-	if (alx_cv_init_img(&in))
-		return	status;
-	if (alx_cv_init_conts(&conts))
-		goto err0;
+	if (!t_reads_inner(*code)) {
+		BITFIELD_SET(code, CODE_IN_POS, CODE_IN_LEN);
+		return	1;
+	}
 
 	/* Find inner match */
-	status--;
-	if (symbol_inner(sym, in))
-		goto err;					dbg_show(2, in);
-	status--;
+	if (!ctx->part[i].has_inner)
+		return	-1;
+	g	= &t_grammar[BITFIELD_READ(*code, CODE_BASE_POS, CODE_BASE_LEN)];
+	in	= ctx->part[i].inner;				dbg_show(2, in);
+	k	= t_pack(&b, in);
+	if (k < 0)
+		return	-1;
 	match	= -INFINITY;
-	BITFIELD_WRITE(code, CODE_IN_POS, CODE_IN_LEN, 0);
-	for (ptrdiff_t i = 0; i < ARRAY_SSIZE(inner_templates); i++) {
-		m	= alx_cv_compare_bitwise(in, inner_templates[i], 2);
+	best	= -1;
+	for (ptrdiff_t j = 0; j < ARRAY_SSIZE(ctx->t->inner); j++) {
+		if (g->inner[j] < 0)
+			continue;
+		m	= bits_match(&b, &ctx->t->bits[k][2 * T_BASE_QTY + j], 2);
 								dbg_printf(4, "match: %.4lf\n", m);
 		if (m >= match) {
-			BITFIELD_WRITE(code, CODE_IN_POS, CODE_IN_LEN, i);
-			match		= m;
-								dbg_printf(4, "%s\n", t_inner_fnames[i]);
+			best	= j;
+			match	= m;
+								dbg_printf(4, "%s\n", t_inner_fnames[j]);
 		}
 	}
-								dbg_show(1, inner_templates[BITFIELD_READ(*code, CODE_IN_POS, CODE_IN_LEN)]);
+	bits_deinit(&b);
+								dbg_show(1, ctx->t->inner[best]);
 
-	t_inner_fix_code(code);
-								dbg_printf(4, "%s\n", t_inner_meaning[BITFIELD_READ(*code, CODE_IN_POS, CODE_IN_LEN)]);
+	BITFIELD_WRITE(code, CODE_IN_POS, CODE_IN_LEN, g->inner[best]);
+								dbg_printf(4, "%s\n", t_inner_meaning[g->inner[best]]);
 
-	/* deinit */
-	status	= 0;
-err:	alx_cv_deinit_conts(conts);
-err0:	alx_cv_deinit_img(in);
-	return	status;
+	return	0;
 }
 
-int	match_t_outer	(img_s *restrict sym, uint32_t *code)
+int	match_t_outer	(const struct Ctx *ctx, ptrdiff_t i, uint32_t *code)
 {
-	img_s		*out;
-	conts_s		*conts;
-	ptrdiff_t	n_lines;
-	int		status;
 
 	if (!BIT_READ(*code, CODE_Y_N_POS)) {
 		BITFIELD_CLEAR(code, CODE_OUT_POS, CODE_OUT_LEN);
 		return	1;
 	}
 
-	/* init */
-	status	= -1;
-	if (alx_cv_init_img(&out))
-		return	status;
-	if (alx_cv_init_conts(&conts))
-		goto err0;
-
-	/* Find inner match */
-	status--;
-	if (symbol_outer(sym, out))
-		goto err;					dbg_show(1, out);
-	status--;
-
-	alx_cv_contours(out, conts);
-	alx_cv_extract_conts(conts, NULL, &n_lines);
-	BITFIELD_WRITE(code, CODE_OUT_POS, CODE_OUT_LEN, n_lines);
-
-	/* deinit */
-	status	= 0;
-err:	alx_cv_deinit_conts(conts);
-err0:	alx_cv_deinit_img(out);
-	return	status;
+	BITFIELD_WRITE(code, CODE_OUT_POS, CODE_OUT_LEN, ctx->part[i].lines);
+	return	0;
 }
 
-void	print_code	(uint32_t code)
+void	fprint_code	(FILE *stream, uint32_t code)
 {
 	ptrdiff_t	base;
 	bool		y_n;
@@ -277,40 +441,69 @@ void	print_code	(uint32_t code)
 	inner	= BITFIELD_READ(code, CODE_IN_POS, CODE_IN_LEN);
 	outer	= BITFIELD_READ(code, CODE_OUT_POS, CODE_OUT_LEN);
 
-	printf("%s", t_base_meaning[base]);
+	fprintf(stream, "%s", t_base_meaning[base]);
 	if (!y_n) {
-		printf(" not\n");
+		fprintf(stream, " not\n");
 	} else {
 		if (inner || outer)
-			printf(": ");
+			fprintf(stream, ": ");
 		if (inner)
-			printf("%s", t_inner_meaning[inner]);
+			fprintf(stream, "%s", t_inner_meaning[inner]);
 		if (inner && outer)
-			printf(", ");
+			fprintf(stream, ", ");
 		if (outer)
-			printf("%s", t_outer_meaning[outer]);
-		fputc('\n', stdout);
+			fprintf(stream, "%s", t_outer_meaning[outer]);
+		fputc('\n', stream);
 	}
 }
 
+void	print_code	(uint32_t code)
+{
+
+	fprint_code(stdout, code);
+}
+
 
 /******************************************************************************
  ******* static function definitions ******************************************
  ******************************************************************************/
+/* Into a single buffer, which is only read afterwards, and hash it */
+static
+int	pack_templates		(struct Templates *t)
+{
+	size_t	size;
+
+	size	= t_bits_size();
+	free(t->packed);
+	t->packed	= malloc(size);
+	if (!t->packed)
+		return	-1;
+
+	t_bits_init(t, t->packed);
+	for (ptrdiff_t k = 0; k < T_SIZES; k++) {
+		for (ptrdiff_t i = 0; i < T_QTY; i++) {
+			if (bits_pack(&t->bits[k][i], t_img(t, i)))
+				return	-1;
+		}
+	}
+	hash128(t->version, t->packed, size);
+	return	0;
+}
+
 static
 int	load_t_inner		(img_s *t, const char *fname)
 {
 	img_s		*tmp;
-	conts_s		*conts;
-	const cont_s	*cont;
+	struct Ccl	*ccl;
 	rect_s		*rect;
+	ptrdiff_t	i;
 	int		status;
 
 	/* init */
 	status	= -1;
 	if (alx_cv_init_img(&tmp))
 		return	status;
-	if (alx_cv_init_conts(&conts))
+	if (init_ccl(&ccl))
 		goto err0;
 	if (alx_cv_init_rect(&rect))
 		goto err1;
@@ -321,82 +514,23 @@ int	load_t_inner		(img_s *t, const char *fname)
 	alx_cv_threshold(t, ALX_CV_THRESH_BINARY_INV, ALX_CV_THR_OTSU);
 	alx_cv_border_black(t, 5);
 	alx_cv_clone(tmp, t);
-	alx_cv_dilate_erode(tmp, 5);
-	alx_cv_contours(tmp, conts);
-	if (alx_cv_conts_largest_a(&cont, NULL, conts))
+	morph_dilate_erode(tmp, 5);
+	if (ccl_label(ccl, tmp))
 		goto err;
-	alx_cv_bounding_rect(rect, cont);
+	i	= ccl_largest_a(ccl);
+	if (i < 0)
+		goto err;
+	ccl_bounding_rect(rect, ccl, i);
 	alx_cv_roi_set(t, rect);				dbg_show(4, t);
 
 	/* deinit */
 	status	= 0;
 err:	alx_cv_deinit_rect(rect);
-err1:	alx_cv_deinit_conts(conts);
+err1:	deinit_ccl(ccl);
 err0:	alx_cv_deinit_img(tmp);
 	return	status;
 }
 
-static
-void	t_inner_fix_code	(uint32_t *code)
-{
-	uint8_t	base_code;
-	uint8_t	in_code;
-
-	base_code	= BITFIELD_READ(*code, CODE_BASE_POS, CODE_BASE_LEN);
-	in_code		= BITFIELD_READ(*code, CODE_IN_POS, CODE_IN_LEN);
-	switch (base_code) {
-	case T_BASE_BLEACH:
-	default:
-		BITFIELD_SET(code, CODE_IN_POS, CODE_IN_LEN);
-		break;
-	case T_BASE_PRO:
-		switch (in_code) {
-		case T_INNER_FNAME_A ... T_INNER_FNAME_W:
-			in_code	+= T_INNER_A - T_INNER_FNAME_A;
-			BITFIELD_WRITE(code, CODE_IN_POS, CODE_IN_LEN, in_code);
-			break;
-		default:
-			BITFIELD_WRITE(code, CODE_IN_POS, CODE_IN_LEN, 0);
-			break;
-		}
-		break;
-		in_code	+= T_INNER_A - T_INNER_FNAME_A;
-		BITFIELD_WRITE(code, CODE_IN_POS, CODE_IN_LEN, in_code);
-		break;
-	case T_BASE_DRY:
-	case T_BASE_IRON:
-		switch (in_code) {
-		case T_INNER_FNAME_1_DOT ... T_INNER_FNAME_3_DOT:
-			in_code	+= T_INNER_LO_T - T_INNER_FNAME_1_DOT;
-			BITFIELD_WRITE(code, CODE_IN_POS, CODE_IN_LEN, in_code);
-			break;
-		default:
-			BITFIELD_WRITE(code, CODE_IN_POS, CODE_IN_LEN, 0);
-			break;
-		}
-		break;
-	case T_BASE_WASH:
-		switch (in_code) {
-		case T_INNER_FNAME_1_DOT ... T_INNER_FNAME_6_DOT:
-			in_code	+= T_INNER_30 - T_INNER_FNAME_1_DOT;
-			BITFIELD_WRITE(code, CODE_IN_POS, CODE_IN_LEN, in_code);
-			break;
-		case T_INNER_FNAME_30 ... T_INNER_FNAME_60:
-			in_code	+= T_INNER_30 - T_INNER_FNAME_30;
-			BITFIELD_WRITE(code, CODE_IN_POS, CODE_IN_LEN, in_code);
-			break;
-		case T_INNER_FNAME_95:
-			in_code	+= T_INNER_95 - T_INNER_FNAME_95;
-			BITFIELD_WRITE(code, CODE_IN_POS, CODE_IN_LEN, in_code);
-			break;
-		default:
-			BITFIELD_WRITE(code, CODE_IN_POS, CODE_IN_LEN, 0);
-			break;
-		}
-		break;
-	}
-}
-
 
 /******************************************************************************
  ******* end of file **********************************************************
@@ -13,20 +13,43 @@
 /******************************************************************************
  ******* headers **************************************************************
  ******************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include <libalx/base/compiler.h>
 #include <libalx/extra/cv/cv.h>
 
+#include "bits.h"
+#include "ctx.h"
+
 
 /******************************************************************************
  ******* macros ***************************************************************
  ******************************************************************************/
 #define TEMPLATES_DIR	"/usr/local/share/laundry-symbol-reader/templates/"
-#define T_BASE_DIR	TEMPLATES_DIR "base/"
-#define T_INNER_DIR	TEMPLATES_DIR "inner/"
+#define T_BASE_DIR	"base/"
+#define T_INNER_DIR	"inner/"
 #define TEMPLATES_EXT	"png"
 
+#define T_QTY		(2 * T_BASE_QTY + T_INNER_QTY)
+
+/*
+ * Version of the preprocessing of the PNGs (load_t_base(), load_t_inner(),
+ * bits_pack(), and what they call).  Bump it whenever their output may change, so that
+ * bundles compiled before are stale (see templates/bundle.h).
+ */
+#define T_PREP_VERSION	(2)
+
+/*
+ * The templates are also kept packed (see bits.h) into squares of these
+ * sides, and a symbol is matched at the smallest one that is not smaller
+ * than it (or at the largest one), so it's packed only once.
+ */
+#define T_SIZES		(3)
+#define T_SIZE(k)	(64 << (k))
+
 #define CODE_BASE_POS	(1)
 #define CODE_BASE_LEN	(3)
 #define CODE_Y_N_POS	(CODE_BASE_POS + CODE_BASE_LEN)
@@ -100,6 +123,33 @@ enum	T_Outer_Meaning {
 /******************************************************************************
  ******* struct / union *******************************************************
  ******************************************************************************/
+/*
+ * What can be read inside a base (when it isn't "not"):  the meaning of
+ * every inner template.  A template that can't be in the base still
+ * competes, and reads as T_INNER_EMPTY if it wins;  only -1 isn't compared
+ * at all.
+ */
+struct	T_Grammar {
+	int8_t	inner[T_INNER_QTY];	/* enum T_Inner_Meaning, or -1 */
+};
+
+/* Loaded once, and then only read (possibly by many contexts at once) */
+struct	Templates {
+	img_s		*base[T_BASE_QTY];
+	img_s		*base_not[T_BASE_QTY];
+	img_s		*inner[T_INNER_QTY];
+	/*
+	 * At every size, in the order of t_img();  the words are in packed,
+	 * or in the map (and then packed is NULL).
+	 */
+	struct Bits	bits[T_SIZES][T_QTY];
+	uint64_t	*packed;
+	/* Hash of packed, to tell results of other templates (see cache.h) */
+	uint64_t	version[2];
+	/* Pixels are in a mapped bundle (see templates/bundle.h) if not NULL */
+	void		*map;
+	size_t		map_size;
+};
 
 
 /******************************************************************************
@@ -110,20 +160,27 @@ extern	const char *const	t_base_fnames[T_BASE_QTY];
 extern	const char *const	t_inner_meaning[T_INNER_MEANING_QTY];
 extern	const char *const	t_inner_fnames[T_INNER_QTY];
 extern	const char *const	t_outer_meaning[T_OUTER_MEANING_QTY];
-
-extern	img_s	*base_templates[ARRAY_SIZE(t_base_fnames)];
-extern	img_s	*base_templates_not[ARRAY_SIZE(t_base_fnames)];
-extern	img_s	*inner_templates[ARRAY_SIZE(t_inner_fnames)];
+extern	const struct T_Grammar	t_grammar[T_BASE_QTY];
 
 
 /******************************************************************************
  ******* prototypes ***********************************************************
  ******************************************************************************/
-int	init_templates	(void);
-void	deinit_templates(void);
-int	load_templates	(void);
-int	match_t_inner	(img_s *restrict sym, uint32_t *code);
-int	match_t_outer	(img_s *restrict sym, uint32_t *code);
+int	init_templates	(struct Templates **t);
+void	deinit_templates(struct Templates *t);
+int	load_templates	(struct Templates *restrict t, const char *restrict dir);
+int	load_templates_png(struct Templates *restrict t,
+			 const char *restrict dir);
+img_s	*t_img		(const struct Templates *t, ptrdiff_t i);
+ptrdiff_t t_pack	(struct Bits *restrict b, const img_s *restrict img);
+size_t	t_bits_size	(void);
+void	t_bits_init	(struct Templates *restrict t, void *restrict packed);
+int	t_fname		(char fname[FILENAME_MAX], const char *restrict dir,
+			 ptrdiff_t i);
+bool	t_reads_inner	(uint32_t code);
+int	match_t_inner	(const struct Ctx *ctx, ptrdiff_t i, uint32_t *code);
+int	match_t_outer	(const struct Ctx *ctx, ptrdiff_t i, uint32_t *code);
+void	fprint_code	(FILE *stream, uint32_t code);
 void	print_code	(uint32_t code);
 
 